@@ -0,0 +1,286 @@
+// Copyright (c) 2016-2019 The MagnaChain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench/bench.h"
+
+#include "chain/chain.h"
+#include "chain/chainparams.h"
+#include "coding/base58.h"
+#include "consensus/tx_verify.h"
+#include "key/key.h"
+#include "misc/random.h"
+#include "smartcontract/smartcontract.h"
+#include "validation/validation.h"
+
+// All contract benchmarks use the same block time, height, sender and
+// deterministic contract ids so that runs can be compared.
+static const int64_t BENCH_BLOCK_TIME = 1500000000;
+static const int BENCH_BLOCK_HEIGHT = 100;
+static const int BENCH_BLOCK_TXS = 64;
+static const int BENCH_CALL_DEPTH = 8;
+
+static const std::string counterContractCode =
+    "function init()\n"
+    "    PersistentData = {}\n"
+    "    PersistentData.count = 0\n"
+    "end\n"
+    "function inc()\n"
+    "    PersistentData.count = PersistentData.count + 1\n"
+    "end\n";
+
+// About 512KiB of persistent data, half the MAX_DATA_LEN limit
+static const std::string largeDataContractCode =
+    "function init()\n"
+    "    PersistentData = {}\n"
+    "    PersistentData.count = 0\n"
+    "    PersistentData.items = {}\n"
+    "    for i = 1, 64 do\n"
+    "        PersistentData.items[i] = string.rep('x', 8192)\n"
+    "    end\n"
+    "end\n"
+    "function inc()\n"
+    "    PersistentData.count = PersistentData.count + 1\n"
+    "end\n";
+
+static MCContractID BenchContractID(int n)
+{
+    return MCContractID(uint160(ParseHex(strprintf("%040x", n + 1))));
+}
+
+// Contract execution needs chain params, a contract database and the index of
+// the previous block. The database stays empty, all contracts live in the
+// ContractContext of the benchmark.
+static MCBlockIndex* SetupContractBench()
+{
+    static MCBlockIndex* pPrevBlockIndex = nullptr;
+    if (pPrevBlockIndex == nullptr) {
+        // genesis block creation signs the coinbase and has its own ECC_Start and ECC_Stop pair
+        SignatureCoinbaseTransactionPF = &SignatureCoinbaseTransaction;
+        ECC_Stop();
+        SelectParams(MCBaseChainParams::REGTEST);
+        ECC_Start();
+        mpContractDb = new ContractDataDB(fs::path("bench_contract"), 1 << 20, true, false);
+
+        FastRandomContext rng(true);
+        pPrevBlockIndex = new MCBlockIndex();
+        pPrevBlockIndex->nHeight = BENCH_BLOCK_HEIGHT - 1;
+        pPrevBlockIndex->nTime = BENCH_BLOCK_TIME;
+        BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(rng.rand256(), pPrevBlockIndex)).first;
+        pPrevBlockIndex->phashBlock = &mi->first;
+    }
+    return pPrevBlockIndex;
+}
+
+static const MCPubKey& BenchSenderPubKey()
+{
+    static MCPubKey pubKey;
+    if (!pubKey.IsValid()) {
+        MCKey key;
+        std::vector<unsigned char> secret(32, 1);
+        key.Set(secret.begin(), secret.end(), true);
+        pubKey = key.GetPubKey();
+    }
+    return pubKey;
+}
+
+static void InitializeBench(SmartLuaState& sls, ContractContext& context, CoinAmountCache& coinAmountCache, int saveType)
+{
+    MagnaChainAddress senderAddr(BenchSenderPubKey().GetID());
+    sls.Initialize(BENCH_BLOCK_TIME, BENCH_BLOCK_HEIGHT, -1, senderAddr, &context, SetupContractBench(), saveType, &coinAmountCache);
+}
+
+static void PublishBenchContract(SmartLuaState& sls, ContractContext& context, CoinAmountCache& coinAmountCache, const MCContractID& contractId, const std::string& code)
+{
+    MagnaChainAddress contractAddr(contractId);
+    UniValue ret(UniValue::VARR);
+    InitializeBench(sls, context, coinAmountCache, SmartLuaState::SAVE_TYPE_DATA);
+    bool success = PublishContract(&sls, contractAddr, code, ret);
+    assert(success);
+}
+
+static void ContractLuaStateCreate(benchmark::State& state)
+{
+    SetupContractBench();
+    SmartLuaState sls;
+    MagnaChainAddress contractAddr(BenchContractID(0));
+    while (state.KeepRunning()) {
+        lua_State* L = sls.GetLuaState(contractAddr);
+        lua_close(L);
+        sls.contractAddrs.clear();
+    }
+}
+
+static void ContractPublish(benchmark::State& state)
+{
+    SmartLuaState sls;
+    ContractContext context;
+    CoinAmountTemp coinAmountTemp;
+    CoinAmountCache coinAmountCache(&coinAmountTemp);
+    while (state.KeepRunning()) {
+        PublishBenchContract(sls, context, coinAmountCache, BenchContractID(0), counterContractCode);
+        context.ClearAll();
+    }
+}
+
+static void CallBenchContract(benchmark::State& state, const std::string& code)
+{
+    SmartLuaState sls;
+    ContractContext context;
+    CoinAmountTemp coinAmountTemp;
+    CoinAmountCache coinAmountCache(&coinAmountTemp);
+    MCContractID contractId = BenchContractID(0);
+    PublishBenchContract(sls, context, coinAmountCache, contractId, code);
+
+    // the result goes to the cache which is dropped, every call sees the same data
+    MagnaChainAddress contractAddr(contractId);
+    UniValue args(UniValue::VARR);
+    while (state.KeepRunning()) {
+        UniValue ret(UniValue::VARR);
+        long maxCallNum = MAX_CONTRACT_CALL;
+        InitializeBench(sls, context, coinAmountCache, SmartLuaState::SAVE_TYPE_CACHE);
+        bool success = CallContract(&sls, contractAddr, 0, "inc", args, maxCallNum, ret);
+        assert(success);
+        context.ClearCache();
+    }
+}
+
+static void ContractCallSmallData(benchmark::State& state)
+{
+    CallBenchContract(state, counterContractCode);
+}
+
+static void ContractCallLargeData(benchmark::State& state)
+{
+    CallBenchContract(state, largeDataContractCode);
+}
+
+static void ContractCallNested(benchmark::State& state)
+{
+    SmartLuaState sls;
+    ContractContext context;
+    CoinAmountTemp coinAmountTemp;
+    CoinAmountCache coinAmountCache(&coinAmountTemp);
+
+    // every contract of the chain calls the next one
+    for (int i = 0; i < BENCH_CALL_DEPTH; ++i) {
+        std::string code = counterContractCode + "function call()\n    PersistentData.count = PersistentData.count + 1\n";
+        if (i + 1 < BENCH_CALL_DEPTH)
+            code += "    callcontract('" + MagnaChainAddress(BenchContractID(i + 1)).ToString() + "', 'call')\n";
+        code += "end\n";
+        PublishBenchContract(sls, context, coinAmountCache, BenchContractID(i), code);
+    }
+
+    MagnaChainAddress contractAddr(BenchContractID(0));
+    UniValue args(UniValue::VARR);
+    while (state.KeepRunning()) {
+        UniValue ret(UniValue::VARR);
+        long maxCallNum = MAX_CONTRACT_CALL;
+        InitializeBench(sls, context, coinAmountCache, SmartLuaState::SAVE_TYPE_CACHE);
+        bool success = CallContract(&sls, contractAddr, 0, "call", args, maxCallNum, ret);
+        assert(success);
+        context.ClearCache();
+    }
+}
+
+static MCTransactionRef MakeBenchContractTx(int nVersion, const MCContractID& contractId, const std::string& codeOrFunc, const MCOutPoint& prevout)
+{
+    MCMutableTransaction tx;
+    tx.nVersion = nVersion;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 10000;
+    tx.vout[0].scriptPubKey = MCScript() << OP_TRUE;
+    tx.pContractData.reset(new ContractData);
+    tx.pContractData->address = contractId;
+    tx.pContractData->sender = BenchSenderPubKey();
+    tx.pContractData->codeOrFunc = codeOrFunc;
+    tx.pContractData->args = "[]";
+    tx.pContractData->amountOut = 0;
+    return MakeTransactionRef(std::move(tx));
+}
+
+// BENCH_BLOCK_TXS contract transactions split into groups of the same size.
+// Each group publishes its own contract and calls it, spending the previous
+// transaction of the group, so the groups are independent.
+static MCBlock MakeBenchContractBlock(int groups)
+{
+    MCBlock block;
+    block.hashPrevBlock = SetupContractBench()->GetBlockHash();
+    block.nTime = BENCH_BLOCK_TIME;
+
+    FastRandomContext rng(true);
+    int groupSize = BENCH_BLOCK_TXS / groups;
+    for (int g = 0; g < groups; ++g) {
+        MCContractID contractId = BenchContractID(g);
+        MCOutPoint prevout(rng.rand256(), 0);
+        for (int i = 0; i < groupSize; ++i) {
+            MCTransactionRef tx = (i == 0) ?
+                MakeBenchContractTx(MCTransaction::PUBLISH_CONTRACT_VERSION, contractId, counterContractCode, prevout) :
+                MakeBenchContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, "inc", prevout);
+            prevout = MCOutPoint(tx->GetHash(), 0);
+            block.vtx.push_back(tx);
+        }
+        block.groupSize.push_back(groupSize);
+    }
+    return block;
+}
+
+static void RunBlockContractBench(benchmark::State& state, int groups)
+{
+    MCBlock block = MakeBenchContractBlock(groups);
+    ContractContext context;
+    CoinAmountTemp coinAmountTemp;
+    CoinAmountCache coinAmountCache(&coinAmountTemp);
+    while (state.KeepRunning()) {
+        bool success = mpContractDb->RunBlockContract(&block, &context, &coinAmountCache);
+        assert(success);
+        context.ClearAll();
+    }
+}
+
+static void ContractRunBlock1Group(benchmark::State& state)
+{
+    RunBlockContractBench(state, 1);
+}
+
+static void ContractRunBlock4Groups(benchmark::State& state)
+{
+    RunBlockContractBench(state, 4);
+}
+
+static void ContractRunBlock16Groups(benchmark::State& state)
+{
+    RunBlockContractBench(state, 16);
+}
+
+static void ContractRunBlock64Groups(benchmark::State& state)
+{
+    RunBlockContractBench(state, 64);
+}
+
+static void ContractBlockMerkleRootWithData(benchmark::State& state)
+{
+    MCBlock block = MakeBenchContractBlock(4);
+    ContractContext context;
+    CoinAmountTemp coinAmountTemp;
+    CoinAmountCache coinAmountCache(&coinAmountTemp);
+    bool success = mpContractDb->RunBlockContract(&block, &context, &coinAmountCache);
+    assert(success);
+    while (state.KeepRunning()) {
+        uint256 root = BlockMerkleRootWithData(block, context);
+        assert(!root.IsNull());
+    }
+}
+
+BENCHMARK(ContractLuaStateCreate);
+BENCHMARK(ContractPublish);
+BENCHMARK(ContractCallSmallData);
+BENCHMARK(ContractCallLargeData);
+BENCHMARK(ContractCallNested);
+BENCHMARK(ContractRunBlock1Group);
+BENCHMARK(ContractRunBlock4Groups);
+BENCHMARK(ContractRunBlock16Groups);
+BENCHMARK(ContractRunBlock64Groups);
+BENCHMARK(ContractBlockMerkleRootWithData);
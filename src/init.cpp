@@ -71,6 +71,7 @@
 #include "chain/branchchain.h"
 #include "chain/branchdb.h"
 #include "smartcontract/contractdb.h"
+#include "smartcontract/contractquery.h"
 
 bool fFeeEstimatesInitialized = false;
 static const bool DEFAULT_PROXYRANDOMIZE = true;
@@ -241,6 +242,12 @@ void Shutdown()
     // up with our current chain to avoid any strange pruning edge cases and make
     // next startup faster by avoiding rescan.
 
+    if (pContractQueryEngine) {
+        UnregisterValidationInterface(pContractQueryEngine);
+        delete pContractQueryEngine;
+        pContractQueryEngine = nullptr;
+    }
+
     {
         LOCK(cs_main);
         if (pcoinsTip != nullptr) {
@@ -248,6 +255,8 @@ void Shutdown()
         }
         delete pcoinListDb;
         pcoinListDb = nullptr;
+        delete paddrHistoryDb;
+        paddrHistoryDb = nullptr;
         delete pcoinsTip;
         pcoinsTip = nullptr;
         delete mpContractDb;
@@ -392,6 +401,9 @@ std::string HelpMessage(HelpMessageMode mode)
     }
     strUsage += HelpMessageOpt("-persistmempool", strprintf(_("Whether to save the mempool on shutdown and load on restart (default: %u)"), DEFAULT_PERSIST_MEMPOOL));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
+    strUsage += HelpMessageOpt("-contractcache=<n>", strprintf(_("Keep the in-memory contract data cache below <n> megabytes, unsaved data may exceed it until the next flush (default: %d)"), DEFAULT_CONTRACT_CACHE));
+    strUsage += HelpMessageOpt("-contractquerycache=<n>", strprintf(_("Number of read-only contract query results to keep in memory (default: %u)"), DEFAULT_CONTRACT_QUERY_CACHE));
+    strUsage += HelpMessageOpt("-contractquerythreads=<n>", strprintf(_("Set the number of threads serving batched read-only contract queries (0 = auto, default: %d)"), DEFAULT_CONTRACT_QUERY_THREADS));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
@@ -406,6 +418,7 @@ std::string HelpMessage(HelpMessageMode mode)
 #ifndef WIN32
     strUsage += HelpMessageOpt("-sysperms", _("Create new files with system default permissions, instead of umask 077 (only effective with disabled wallet functionality)"));
 #endif
+    strUsage += HelpMessageOpt("-addrhistoryindex", strprintf(_("Maintain an index of the transactions of every address, used by the getaddresshistory rpc call (default: %u)"), DEFAULT_ADDRHISTORYINDEX));
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), DEFAULT_TXINDEX));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
@@ -939,6 +952,8 @@ bool AppInitParameterInteraction()
     if (gArgs.GetArg("-prune", 0)) {
         if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (gArgs.GetBoolArg("-addrhistoryindex", DEFAULT_ADDRHISTORYINDEX))
+            return InitError(_("Prune mode is incompatible with -addrhistoryindex."));
     }
 
     // -bind and -whitebind can't be set when not listening
@@ -1436,6 +1451,11 @@ bool AppInitMain(boost::thread_group& threadGroup, MCScheduler& scheduler)
     int64_t nBlockTreeDBCache = nTotalCache / 8;
     nBlockTreeDBCache = std::min(nBlockTreeDBCache, (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
     nTotalCache -= nBlockTreeDBCache;
+    int64_t nAddrHistoryDBCache = 0;
+    if (gArgs.GetBoolArg("-addrhistoryindex", DEFAULT_ADDRHISTORYINDEX)) {
+        nAddrHistoryDBCache = std::min(nTotalCache / 8, nMaxAddrHistoryDBCache << 20);
+        nTotalCache -= nAddrHistoryDBCache;
+    }
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1444,7 +1464,11 @@ bool AppInitMain(boost::thread_group& threadGroup, MCScheduler& scheduler)
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
+    if (nAddrHistoryDBCache > 0)
+        LogPrintf("* Using %.1fMiB for address history index database\n", nAddrHistoryDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    int64_t nContractCacheUsage = std::max<int64_t>(gArgs.GetArg("-contractcache", DEFAULT_CONTRACT_CACHE), 0) << 20;
+    LogPrintf("* Using %.1fMiB for in-memory contract data\n", nContractCacheUsage * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     while (!fLoaded && !fRequestShutdown) {
@@ -1458,6 +1482,8 @@ bool AppInitMain(boost::thread_group& threadGroup, MCScheduler& scheduler)
             try {
                 UnloadBlockIndex();
                 delete pcoinsTip;
+                delete paddrHistoryDb;
+                paddrHistoryDb = nullptr;
 				delete mpContractDb;
 				delete pBranchChainTxRecordsDb;
                 delete pcoinsdbview;
@@ -1537,7 +1563,9 @@ bool AppInitMain(boost::thread_group& threadGroup, MCScheduler& scheduler)
                 // The on-disk coinsdb is now in a good state, create the cache
                 pcoinsTip = new MCCoinsViewCache(pcoinscatcher);
 				pcoinListDb = new CoinListDB( pcoinsdbview->GetDb() );
-				mpContractDb = new ContractDataDB(GetDataDir() / "contract", nCoinDBCache, false, false);
+                if (nAddrHistoryDBCache > 0)
+                    paddrHistoryDb = new AddressHistoryDB(nAddrHistoryDBCache, false, fReset || fReindexChainState);
+				mpContractDb = new ContractDataDB(GetDataDir() / "contract", nCoinDBCache, false, false, nContractCacheUsage);
                 pBranchChainTxRecordsDb = new BranchChainTxRecordsDb(GetDataDir() / "branchchaintx", nCoinDBCache, false, false);
                 pCoinAmountDB = new CoinAmountDB();
                 pCoinAmountCache = new CoinAmountCache(pCoinAmountDB);
@@ -1648,6 +1676,13 @@ bool AppInitMain(boost::thread_group& threadGroup, MCScheduler& scheduler)
         LogPrintf(" block index %15dms\n", GetTimeMillis() - nStart);
     }
 
+    {
+        LOCK(cs_main);
+        pContractQueryEngine = new ContractQueryEngine(chainActive.Tip(), gArgs.GetArg("-contractquerythreads", DEFAULT_CONTRACT_QUERY_THREADS),
+            gArgs.GetArg("-contractquerycache", DEFAULT_CONTRACT_QUERY_CACHE));
+    }
+    RegisterValidationInterface(pContractQueryEngine);
+
     fs::path est_path = GetDataDir() / FEE_ESTIMATES_FILENAME;
     MCAutoFile est_filein(fsbridge::fopen(est_path, "rb"), SER_DISK, CLIENT_VERSION);
     // Allowed to fail as this file IS missing on first startup.
@@ -1710,6 +1745,8 @@ bool AppInitMain(boost::thread_group& threadGroup, MCScheduler& scheduler)
     }
 
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
+    if (paddrHistoryDb)
+        threadGroup.create_thread(&ThreadAddressHistoryIndex);
 
     // Wait for genesis block to be processed
     {
@@ -11,6 +11,7 @@
 #include "primitives/transaction.h"
 #include "validation/validation.h"
 #include "net/http/httpserver.h"
+#include "rpc/addressrpc.h"
 #include "rpc/blockchain.h"
 #include "rpc/server.h"
 #include "io/streams.h"
@@ -586,6 +587,108 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
     return true; // continue to process further HTTP reqs on this cxn
 }
 
+// splits "path?key=value&..." into the path and its query parameters
+static std::string ParseQueryString(const std::string& strReq, std::map<std::string, std::string>& params)
+{
+    const std::string::size_type pos = strReq.find('?');
+    if (pos == std::string::npos)
+        return strReq;
+
+    const std::string strQuery = strReq.substr(pos + 1);
+    std::vector<std::string> items;
+    boost::split(items, strQuery, boost::is_any_of("&"));
+    for (const std::string& item : items) {
+        const std::string::size_type eq = item.find('=');
+        if (eq == std::string::npos)
+            params[item] = "";
+        else
+            params[item.substr(0, eq)] = item.substr(eq + 1);
+    }
+    return strReq.substr(0, pos);
+}
+
+static bool rest_address(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::map<std::string, std::string> query;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, ParseQueryString(strURIPart, query));
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid URI format. Expected /rest/address/<address>/<utxos|balance|mempool>.<ext>");
+
+    uint160 key;
+    if (!ParseAddressKey(path[0], key))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid address: " + path[0]);
+
+    // the index is read under cs_main, serialization happens after the lock is released
+    MCDataStream ssAddress(SER_NETWORK, PROTOCOL_VERSION);
+    UniValue jsonAddress;
+    if (path[1] == "utxos") {
+        MCOutPoint cursor;
+        if (!ParseAddressCursor(query["cursor"], cursor))
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid cursor: " + query["cursor"]);
+        int32_t limit = DEFAULT_ADDRESS_PAGE_SIZE;
+        if (query.count("limit") && (!ParseInt32(query["limit"], &limit) || limit < 1 || limit > (int32_t)MAX_ADDRESS_PAGE_SIZE))
+            return RESTERR(req, HTTP_BAD_REQUEST, "Invalid limit: " + query["limit"]);
+
+        AddressUtxoPage page;
+        GetAddressUtxos(key, cursor, limit, page);
+        if (rf == RF_JSON)
+            jsonAddress = AddressUtxoPageToJSON(page);
+        else
+            ssAddress << page;
+    } else if (path[1] == "balance") {
+        AddressBalance balance;
+        GetAddressBalance(key, balance);
+        if (rf == RF_JSON)
+            jsonAddress = AddressBalanceToJSON(balance);
+        else
+            ssAddress << balance;
+    } else if (path[1] == "mempool") {
+        std::vector<AddressMempoolDelta> deltas;
+        GetAddressMempool(key, deltas);
+        if (rf == RF_JSON)
+            jsonAddress = AddressMempoolToJSON(deltas);
+        else
+            ssAddress << deltas;
+    } else {
+        return RESTERR(req, HTTP_NOT_FOUND, "Unknown address resource: " + path[1]);
+    }
+
+    switch (rf) {
+    case RF_BINARY: {
+        std::string binaryAddress = ssAddress.str();
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, binaryAddress);
+        return true;
+    }
+
+    case RF_HEX: {
+        std::string strHex = HexStr(ssAddress.begin(), ssAddress.end()) + "\n";
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, strHex);
+        return true;
+    }
+
+    case RF_JSON: {
+        std::string strJSON = jsonAddress.write() + "\n";
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, strJSON);
+        return true;
+    }
+    default: {
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+    }
+
+    // not reached
+    return true; // continue to process further HTTP reqs on this cxn
+}
+
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
@@ -598,6 +701,7 @@ static const struct {
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
       {"/rest/getutxos", rest_getutxos},
+      {"/rest/address/", rest_address},
 };
 
 bool StartREST()
@@ -2132,18 +2132,33 @@ bool static ProcessMessage(MCNode* pfrom, const std::string& strCommand, MCDataS
             // Recursively process any orphan transactions that depended on this one
             std::set<NodeId> setMisbehaving;
             while (!vWorkQueue.empty()) {
-                auto itByPrev = mapOrphanTransactionsByPrev.find(vWorkQueue.front());
-                vWorkQueue.pop_front();
-                if (itByPrev == mapOrphanTransactionsByPrev.end())
-                    continue;
-                for (auto mi = itByPrev->second.begin();
-                     mi != itByPrev->second.end();
-                     ++mi)
+                // Collect every orphan unlocked by the current generation so that
+                // their smart contracts are executed together
+                std::vector<MCTransactionRef> vOrphans;
+                std::vector<NodeId> vOrphanFrom;
+                std::set<uint256> setOrphanQueued;
+                for (const MCOutPoint& outpoint : vWorkQueue) {
+                    auto itByPrev = mapOrphanTransactionsByPrev.find(outpoint);
+                    if (itByPrev == mapOrphanTransactionsByPrev.end())
+                        continue;
+                    for (auto mi = itByPrev->second.begin(); mi != itByPrev->second.end(); ++mi) {
+                        if (setOrphanQueued.insert((*mi)->first).second) {
+                            vOrphans.push_back((*mi)->second.tx);
+                            vOrphanFrom.push_back((*mi)->second.fromPeer);
+                        }
+                    }
+                }
+                vWorkQueue.clear();
+                if (vOrphans.empty())
+                    break;
+
+                MemPoolAcceptBatch acceptBatch(mempool, vOrphans);
+                for (size_t i = 0; i < vOrphans.size(); ++i)
                 {
-                    const MCTransactionRef& porphanTx = (*mi)->second.tx;
+                    const MCTransactionRef& porphanTx = vOrphans[i];
                     const MCTransaction& orphanTx = *porphanTx;
                     const uint256& orphanHash = orphanTx.GetHash();
-                    NodeId fromPeer = (*mi)->second.fromPeer;
+                    NodeId fromPeer = vOrphanFrom[i];
                     bool fMissingInputs2 = false;
                     // Use a dummy MCValidationState so someone can't setup nodes to counter-DoS based on orphan
                     // resolution (that is, feeding people an invalid transaction based on LegitTxX in order to get
@@ -2153,7 +2168,7 @@ bool static ProcessMessage(MCNode* pfrom, const std::string& strCommand, MCDataS
 
                     if (setMisbehaving.count(fromPeer))
                         continue;
-                    if (AcceptToMemoryPool(mempool, stateDummy, porphanTx, true, &fMissingInputs2, &lRemovedTxn)) {
+                    if (acceptBatch.Accept(i, stateDummy, true, &fMissingInputs2, &lRemovedTxn)) {
                         LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
                         RelayTransaction(orphanTx, connman);
                         for (unsigned int i = 0; i < orphanTx.vout.size(); i++) {
@@ -293,13 +293,56 @@ public:
     }
 };
 
+// 合约代码或数据的不可变共享块，复制时只增加引用计数，序列化格式与std::string相同
+class ContractBlob
+{
+public:
+    ContractBlob() {}
+    ContractBlob(const char* str) : blob(std::make_shared<const std::string>(str)) {}
+    ContractBlob(const std::string& str) : blob(std::make_shared<const std::string>(str)) {}
+    ContractBlob(std::string&& str) : blob(std::make_shared<const std::string>(std::move(str))) {}
+    explicit ContractBlob(const std::shared_ptr<const std::string>& ref) : blob(ref) {}
+
+    const std::string& str() const
+    {
+        static const std::string empty;
+        return blob ? *blob : empty;
+    }
+    operator const std::string&() const { return str(); }
+    size_t size() const { return str().size(); }
+    bool empty() const { return str().empty(); }
+    // 两者引用同一块内存
+    bool SharesWith(const ContractBlob& other) const { return blob && blob == other.blob; }
+    const std::shared_ptr<const std::string>& GetRef() const { return blob; }
+
+    friend bool operator==(const ContractBlob& a, const ContractBlob& b) { return a.blob == b.blob || a.str() == b.str(); }
+    friend bool operator!=(const ContractBlob& a, const ContractBlob& b) { return !(a == b); }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << str();
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        std::string str;
+        s >> str;
+        blob = std::make_shared<const std::string>(std::move(str));
+    }
+
+private:
+    std::shared_ptr<const std::string> blob;
+};
+
 // 执行智能合约时的上下文数据
 class ContractInfo
 {
 public:
     ContractDataFrom from;
-    std::string code;
-    std::string data;
+    ContractBlob code;
+    ContractBlob data;
 
     ContractInfo() {};
 
@@ -0,0 +1,418 @@
+// Copyright (c) 2016-2019 The MagnaChain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/addressrpc.h"
+
+#include "coding/base58.h"
+#include "chain/chain.h"
+#include "consensus/consensus.h"
+#include "io/core_io.h"
+#include "rpc/server.h"
+#include "transaction/txdb.h"
+#include "transaction/txmempool.h"
+#include "validation/validation.h"
+#include "utils/utilstrencodings.h"
+#include "univalue.h"
+
+#include <stdint.h>
+
+bool ParseAddressKey(const std::string& strAddr, uint160& key)
+{
+    MagnaChainAddress addr(strAddr);
+    if (!addr.IsValid())
+        return false;
+
+    MCContractID contractId;
+    MCKeyID keyId;
+    if (addr.GetContractID(contractId))
+        key = contractId;
+    else if (addr.GetKeyID(keyId))
+        key = keyId;
+    else
+        return false;
+    return true;
+}
+
+bool ParseAddressCursor(const std::string& strCursor, MCOutPoint& cursor)
+{
+    cursor.SetNull();
+    if (strCursor.empty())
+        return true;
+
+    std::string::size_type pos = strCursor.find(':');
+    if (pos != 64 || !IsHex(strCursor.substr(0, pos)))
+        return false;
+    int32_t n;
+    if (!ParseInt32(strCursor.substr(pos + 1), &n) || n < 0)
+        return false;
+    cursor = MCOutPoint(uint256S(strCursor.substr(0, pos)), n);
+    return true;
+}
+
+std::string AddressCursorToString(const MCOutPoint& cursor)
+{
+    if (cursor.IsNull())
+        return "";
+    return strprintf("%s:%u", cursor.hash.ToString(), cursor.n);
+}
+
+void GetAddressUtxos(const uint160& key, const MCOutPoint& cursor, size_t limit, AddressUtxoPage& page)
+{
+    std::vector<MCOutPoint> outpoints;
+    {
+        LOCK(cs_main);
+        CoinListPtr plist = pcoinListDb->GetList(key);
+        if (plist != nullptr)
+            outpoints = plist->coins;
+    }
+
+    // 列表按写入顺序保存，排序后用outpoint作游标，两次查询之间列表变化也不会重复或跳过
+    std::sort(outpoints.begin(), outpoints.end());
+    std::vector<MCOutPoint>::const_iterator it = outpoints.begin();
+    if (!cursor.IsNull())
+        it = std::upper_bound(outpoints.begin(), outpoints.end(), cursor);
+
+    page.coins.clear();
+    page.nextCursor.SetNull();
+    LOCK(cs_main);
+    page.nHeight = chainActive.Height();
+    page.hashBlock = chainActive.Tip()->GetBlockHash();
+    for (; it != outpoints.end(); ++it) {
+        if (page.coins.size() >= limit) {
+            page.nextCursor = page.coins.back().first;
+            break;
+        }
+        const Coin& coin = pcoinsTip->AccessCoin(*it);
+        if (!coin.IsSpent())
+            page.coins.push_back(std::make_pair(*it, coin));
+    }
+}
+
+void GetAddressBalance(const uint160& key, AddressBalance& balance)
+{
+    LOCK(cs_main);
+    CoinListPtr plist = pcoinListDb->GetList(key);
+    balance.nHeight = chainActive.Height();
+    balance.hashBlock = chainActive.Tip()->GetBlockHash();
+    balance.balance = 0;
+    balance.immature = 0;
+    balance.coinCount = 0;
+    if (plist == nullptr)
+        return;
+
+    for (const MCOutPoint& outpoint : plist->coins) {
+        const Coin& coin = pcoinsTip->AccessCoin(outpoint);
+        if (coin.IsSpent())
+            continue;
+        balance.coinCount++;
+        if (coin.IsCoinBase() && balance.nHeight - coin.nHeight < COINBASE_MATURITY)
+            balance.immature += coin.out.nValue;
+        else
+            balance.balance += coin.out.nValue;
+    }
+}
+
+void GetAddressMempool(const uint160& key, std::vector<AddressMempoolDelta>& deltas)
+{
+    deltas.clear();
+    LOCK2(cs_main, mempool.cs);
+    for (const MCTxMemPoolEntry& entry : mempool.mapTx) {
+        const MCTransaction& tx = entry.GetTx();
+        for (uint32_t i = 0; i < tx.vin.size(); ++i) {
+            const MCOutPoint& prevout = tx.vin[i].prevout;
+            MCTransactionRef prevTx = mempool.get(prevout.hash);
+            const MCTxOut* prevOut = nullptr;
+            if (prevTx != nullptr) {
+                if (prevout.n < prevTx->vout.size())
+                    prevOut = &prevTx->vout[prevout.n];
+            }
+            else {
+                const Coin& coin = pcoinsTip->AccessCoin(prevout);
+                if (!coin.IsSpent())
+                    prevOut = &coin.out;
+            }
+
+            uint160 prevKey;
+            if (prevOut == nullptr || !GetScriptCoinListKey(prevOut->scriptPubKey, prevKey) || prevKey != key)
+                continue;
+            AddressMempoolDelta delta;
+            delta.txid = tx.GetHash();
+            delta.index = i;
+            delta.prevout = prevout;
+            delta.amount = -prevOut->nValue;
+            delta.time = entry.GetTime();
+            deltas.push_back(delta);
+        }
+
+        for (uint32_t i = 0; i < tx.vout.size(); ++i) {
+            uint160 outKey;
+            if (!GetScriptCoinListKey(tx.vout[i].scriptPubKey, outKey) || outKey != key)
+                continue;
+            AddressMempoolDelta delta;
+            delta.txid = tx.GetHash();
+            delta.index = i;
+            delta.amount = tx.vout[i].nValue;
+            delta.time = entry.GetTime();
+            deltas.push_back(delta);
+        }
+    }
+}
+
+UniValue AddressUtxoPageToJSON(const AddressUtxoPage& page)
+{
+    UniValue utxos(UniValue::VARR);
+    for (const auto& item : page.coins) {
+        UniValue utxo(UniValue::VOBJ);
+        utxo.push_back(Pair("txid", item.first.hash.GetHex()));
+        utxo.push_back(Pair("vout", (int64_t)item.first.n));
+        utxo.push_back(Pair("amount", ValueFromAmount(item.second.out.nValue)));
+        utxo.push_back(Pair("scriptPubKey", HexStr(item.second.out.scriptPubKey.begin(), item.second.out.scriptPubKey.end())));
+        utxo.push_back(Pair("height", (int64_t)item.second.nHeight));
+        utxo.push_back(Pair("coinbase", item.second.IsCoinBase()));
+        utxos.push_back(utxo);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("height", page.nHeight));
+    ret.push_back(Pair("bestblock", page.hashBlock.GetHex()));
+    ret.push_back(Pair("utxos", utxos));
+    if (!page.nextCursor.IsNull())
+        ret.push_back(Pair("nextcursor", AddressCursorToString(page.nextCursor)));
+    return ret;
+}
+
+UniValue AddressBalanceToJSON(const AddressBalance& balance)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("height", balance.nHeight));
+    ret.push_back(Pair("bestblock", balance.hashBlock.GetHex()));
+    ret.push_back(Pair("balance", ValueFromAmount(balance.balance)));
+    ret.push_back(Pair("immature", ValueFromAmount(balance.immature)));
+    ret.push_back(Pair("utxocount", balance.coinCount));
+    return ret;
+}
+
+UniValue AddressMempoolToJSON(const std::vector<AddressMempoolDelta>& deltas)
+{
+    UniValue ret(UniValue::VARR);
+    for (const AddressMempoolDelta& delta : deltas) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("txid", delta.txid.GetHex()));
+        obj.push_back(Pair("index", (int64_t)delta.index));
+        obj.push_back(Pair("amount", ValueFromAmount(delta.amount)));
+        obj.push_back(Pair("time", delta.time));
+        if (!delta.prevout.IsNull()) {
+            obj.push_back(Pair("prevtxid", delta.prevout.hash.GetHex()));
+            obj.push_back(Pair("prevout", (int64_t)delta.prevout.n));
+        }
+        ret.push_back(obj);
+    }
+    return ret;
+}
+
+static uint160 ParseAddressKeyV(const UniValue& param)
+{
+    uint160 key;
+    if (!ParseAddressKey(param.get_str(), key))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid MagnaChain public key or contract address");
+    return key;
+}
+
+UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddressutxos \"address\" ( \"cursor\" limit )\n"
+            "\nReturns one page of the unspent outputs of an address, ordered by outpoint.\n"
+            "The address index is updated when the coins cache is flushed.\n"
+            "\nArguments:\n"
+            "1. \"address\"   (string, required) Public key or contract address\n"
+            "2. \"cursor\"    (string, optional) \"nextcursor\" of the previous page, empty for the first page\n"
+            "3. limit       (numeric, optional, default=" + std::to_string(DEFAULT_ADDRESS_PAGE_SIZE) + ") Outputs per page, at most " + std::to_string(MAX_ADDRESS_PAGE_SIZE) + "\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"height\": n,            (numeric) Chain height of the page\n"
+            "  \"bestblock\": \"hash\",    (string) Chain tip of the page\n"
+            "  \"utxos\": [\n"
+            "    {\n"
+            "      \"txid\": \"txid\",     (string) Transaction id\n"
+            "      \"vout\": n,          (numeric) Output index\n"
+            "      \"amount\": x.xxx,    (numeric) Value in " + CURRENCY_UNIT + "\n"
+            "      \"scriptPubKey\": \"hex\", (string) Output script\n"
+            "      \"height\": n,        (numeric) Height of the block of the output\n"
+            "      \"coinbase\": true|false (boolean) Output of a coinbase transaction\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"nextcursor\": \"cursor\"  (string) Cursor of the next page, missing on the last page\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressutxos", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\"")
+            + HelpExampleRpc("getaddressutxos", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\", \"\", 100"));
+
+    uint160 key = ParseAddressKeyV(request.params[0]);
+    MCOutPoint cursor;
+    if (!request.params[1].isNull() && !ParseAddressCursor(request.params[1].get_str(), cursor))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    int limit = DEFAULT_ADDRESS_PAGE_SIZE;
+    if (!request.params[2].isNull())
+        limit = request.params[2].get_int();
+    if (limit < 1 || limit > (int)MAX_ADDRESS_PAGE_SIZE)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid limit");
+
+    AddressUtxoPage page;
+    GetAddressUtxos(key, cursor, limit, page);
+    return AddressUtxoPageToJSON(page);
+}
+
+UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddressbalance \"address\"\n"
+            "\nReturns the confirmed balance of an address from the address index.\n"
+            "\nArguments:\n"
+            "1. \"address\"   (string, required) Public key or contract address\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"height\": n,            (numeric) Chain height of the balance\n"
+            "  \"bestblock\": \"hash\",    (string) Chain tip of the balance\n"
+            "  \"balance\": x.xxx,       (numeric) Spendable balance in " + CURRENCY_UNIT + "\n"
+            "  \"immature\": x.xxx,      (numeric) Immature coinbase outputs in " + CURRENCY_UNIT + "\n"
+            "  \"utxocount\": n          (numeric) Number of unspent outputs\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressbalance", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\"")
+            + HelpExampleRpc("getaddressbalance", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\""));
+
+    uint160 key = ParseAddressKeyV(request.params[0]);
+    AddressBalance balance;
+    GetAddressBalance(key, balance);
+    return AddressBalanceToJSON(balance);
+}
+
+UniValue getaddressmempool(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddressmempool \"address\"\n"
+            "\nReturns the mempool transactions that pay to or spend from an address.\n"
+            "\nArguments:\n"
+            "1. \"address\"   (string, required) Public key or contract address\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\": \"txid\",       (string) Mempool transaction id\n"
+            "    \"index\": n,           (numeric) Output index, or input index when spending\n"
+            "    \"amount\": x.xxx,      (numeric) Received amount, negative when spending\n"
+            "    \"time\": n,            (numeric) Time the transaction entered the mempool\n"
+            "    \"prevtxid\": \"txid\",   (string) Spent transaction, only when spending\n"
+            "    \"prevout\": n          (numeric) Spent output, only when spending\n"
+            "  }, ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressmempool", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\"")
+            + HelpExampleRpc("getaddressmempool", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\""));
+
+    uint160 key = ParseAddressKeyV(request.params[0]);
+    std::vector<AddressMempoolDelta> deltas;
+    GetAddressMempool(key, deltas);
+    return AddressMempoolToJSON(deltas);
+}
+
+UniValue getaddresshistory(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 5)
+        throw std::runtime_error(
+            "getaddresshistory \"address\" ( startheight endheight \"cursor\" limit )\n"
+            "\nReturns the transactions of the active chain that touch an address, in chain order.\n"
+            "Outputs, spent outputs, contract calls and contract senders are indexed. Requires -addrhistoryindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"     (string, required) Public key or contract address\n"
+            "2. startheight   (numeric, optional, default=0) First block height\n"
+            "3. endheight     (numeric, optional, default=tip) Last block height\n"
+            "4. \"cursor\"      (string, optional) \"nextcursor\" of the previous page, overrides startheight\n"
+            "5. limit         (numeric, optional, default=" + std::to_string(DEFAULT_ADDRESS_PAGE_SIZE) + ") Transactions per page, at most " + std::to_string(MAX_ADDRESS_PAGE_SIZE) + "\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"indexedheight\": n,     (numeric) Height up to which the index is complete\n"
+            "  \"history\": [\n"
+            "    {\n"
+            "      \"txid\": \"txid\",     (string) Transaction id\n"
+            "      \"height\": n,        (numeric) Block height\n"
+            "      \"txindex\": n,       (numeric) Position of the transaction in the block\n"
+            "      \"blockhash\": \"hash\" (string) Block hash\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"nextcursor\": \"cursor\"  (string) Cursor of the next page, missing on the last page\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresshistory", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\"")
+            + HelpExampleRpc("getaddresshistory", "\"XWe2pCTzL2RQ9RBEqpvtqXPd8bTKsXNoiM\", 1000, 2000"));
+
+    if (!paddrHistoryDb)
+        throw JSONRPCError(RPC_MISC_ERROR, "Address history index is disabled, restart with -addrhistoryindex");
+
+    uint160 key = ParseAddressKeyV(request.params[0]);
+    int nStartHeight = request.params[1].isNull() ? 0 : request.params[1].get_int();
+    int nEndHeight = request.params[2].isNull() ? -1 : request.params[2].get_int();
+    uint32_t nStartTxIndex = 0;
+    if (!request.params[3].isNull() && !request.params[3].get_str().empty()) {
+        std::string strCursor = request.params[3].get_str();
+        size_t pos = strCursor.find(':');
+        int32_t nHeight, nTxIndex;
+        if (pos == std::string::npos || !ParseInt32(strCursor.substr(0, pos), &nHeight) || !ParseInt32(strCursor.substr(pos + 1), &nTxIndex) || nHeight < 0 || nTxIndex < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        nStartHeight = nHeight;
+        nStartTxIndex = nTxIndex;
+    }
+    if (nStartHeight < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid startheight");
+    int limit = DEFAULT_ADDRESS_PAGE_SIZE;
+    if (!request.params[4].isNull())
+        limit = request.params[4].get_int();
+    if (limit < 1 || limit > (int)MAX_ADDRESS_PAGE_SIZE)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid limit");
+
+    // read one entry more than asked to know whether there is a next page
+    AddressHistoryEntries entries;
+    if (!paddrHistoryDb->ReadHistory(key, nStartHeight, nStartTxIndex, nEndHeight, limit + 1, entries))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to read the address history index");
+
+    UniValue ret(UniValue::VOBJ);
+    UniValue history(UniValue::VARR);
+    LOCK(cs_main);
+    BlockMap::iterator mi = mapBlockIndex.find(paddrHistoryDb->GetBestBlock());
+    ret.push_back(Pair("indexedheight", mi == mapBlockIndex.end() ? -1 : mi->second->nHeight));
+    for (size_t i = 0; i < entries.size() && i < (size_t)limit; i++) {
+        const MCBlockIndex* pindex = chainActive[entries[i].first.nHeight];
+        // entries above the tip are left over from blocks that are no longer connected
+        if (!pindex)
+            break;
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("txid", entries[i].second.GetHex()));
+        entry.push_back(Pair("height", (int)entries[i].first.nHeight));
+        entry.push_back(Pair("txindex", (int)entries[i].first.nTxIndex));
+        entry.push_back(Pair("blockhash", pindex->GetBlockHash().GetHex()));
+        history.push_back(entry);
+    }
+    ret.push_back(Pair("history", history));
+    if (entries.size() > (size_t)limit && chainActive[entries.back().first.nHeight])
+        ret.push_back(Pair("nextcursor", strprintf("%u:%u", entries.back().first.nHeight, entries.back().first.nTxIndex)));
+    return ret;
+}
+
+static const CRPCCommand commands[] =
+{ //  category              name                         actor (function)              okSafeMode
+    //  --------------------- ------------------------     -----------------------       ----------
+    { "addressindex",       "getaddressutxos",           &getaddressutxos,             true,  {"address", "cursor", "limit"} },
+    { "addressindex",       "getaddressbalance",         &getaddressbalance,           true,  {"address"} },
+    { "addressindex",       "getaddressmempool",         &getaddressmempool,           true,  {"address"} },
+    { "addressindex",       "getaddresshistory",         &getaddresshistory,           true,  {"address", "startheight", "endheight", "cursor", "limit"} },
+};
+
+void RegisterAddressRPCCommands(CRPCTable& t)
+{
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
+        t.appendCommand(commands[vcidx].name, &commands[vcidx]);
+}
@@ -0,0 +1,102 @@
+// Copyright (c) 2016-2019 The MagnaChain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef MAGNACHAIN_RPC_ADDRESSRPC_H
+#define MAGNACHAIN_RPC_ADDRESSRPC_H
+
+#include "primitives/transaction.h"
+#include "transaction/coins.h"
+#include "coding/uint256.h"
+
+#include <string>
+#include <vector>
+
+class UniValue;
+
+static const unsigned int DEFAULT_ADDRESS_PAGE_SIZE = 1000;
+static const unsigned int MAX_ADDRESS_PAGE_SIZE = 10000;
+
+// 地址的一页未花费输出，按outpoint排序，cursor为上一页最后一个outpoint
+class AddressUtxoPage
+{
+public:
+    int nHeight;
+    uint256 hashBlock;
+    std::vector<std::pair<MCOutPoint, Coin>> coins;
+    MCOutPoint nextCursor;   // 为空时已没有下一页
+
+    AddressUtxoPage() : nHeight(-1) {}
+
+    ADD_SERIALIZE_METHODS;
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nHeight);
+        READWRITE(hashBlock);
+        READWRITE(coins);
+        READWRITE(nextCursor);
+    }
+};
+
+class AddressBalance
+{
+public:
+    int nHeight;
+    uint256 hashBlock;
+    MCAmount balance;     // 已成熟的余额
+    MCAmount immature;    // 未成熟的挖矿奖励
+    uint64_t coinCount;
+
+    AddressBalance() : nHeight(-1), balance(0), immature(0), coinCount(0) {}
+
+    ADD_SERIALIZE_METHODS;
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nHeight);
+        READWRITE(hashBlock);
+        READWRITE(balance);
+        READWRITE(immature);
+        READWRITE(coinCount);
+    }
+};
+
+// 内存池交易对地址的收支，spending时outpoint为被花费的输出
+class AddressMempoolDelta
+{
+public:
+    uint256 txid;
+    uint32_t index;
+    MCOutPoint prevout;
+    MCAmount amount;
+    int64_t time;
+
+    ADD_SERIALIZE_METHODS;
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(txid);
+        READWRITE(index);
+        READWRITE(prevout);
+        READWRITE(amount);
+        READWRITE(time);
+    }
+};
+
+// 普通地址与合约地址都可查询，返回CoinListDB的key
+bool ParseAddressKey(const std::string& strAddr, uint160& key);
+// "txid:n"格式的分页游标，空串表示第一页
+bool ParseAddressCursor(const std::string& strCursor, MCOutPoint& cursor);
+std::string AddressCursorToString(const MCOutPoint& cursor);
+
+// 只在复制outpoint列表和读取coin时持有cs_main，排序与序列化都在锁外进行
+void GetAddressUtxos(const uint160& key, const MCOutPoint& cursor, size_t limit, AddressUtxoPage& page);
+void GetAddressBalance(const uint160& key, AddressBalance& balance);
+void GetAddressMempool(const uint160& key, std::vector<AddressMempoolDelta>& deltas);
+
+UniValue AddressUtxoPageToJSON(const AddressUtxoPage& page);
+UniValue AddressBalanceToJSON(const AddressBalance& balance);
+UniValue AddressMempoolToJSON(const std::vector<AddressMempoolDelta>& deltas);
+
+#endif
@@ -810,20 +810,6 @@ UniValue getlastblock_tx(const JSONRPCRequest& request)
 	return result;
 }
 
-struct MCCoinsStats
-{
-    int nHeight;
-    uint256 hashBlock;
-    uint64_t nTransactions;
-    uint64_t nTransactionOutputs;
-    uint64_t nBogoSize;
-    uint256 hashSerialized;
-    uint64_t nDiskSize;
-    MCAmount nTotalAmount;
-
-    MCCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
-};
-
 static void ApplyStats(MCCoinsStats &stats, MCHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
     assert(!outputs.empty());
@@ -843,7 +829,7 @@ static void ApplyStats(MCCoinsStats &stats, MCHashWriter& ss, const uint256& has
 }
 
 //! Calculate statistics about the unspent transaction output set
-static bool GetUTXOStats(MCCoinsView *view, MCCoinsStats &stats)
+bool GetUTXOStats(MCCoinsView *view, MCCoinsStats &stats)
 {
     std::unique_ptr<MCCoinsViewCursor> pcursor(view->Cursor());
 
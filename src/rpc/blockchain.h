@@ -6,10 +6,30 @@
 #ifndef MAGNACHAIN_RPC_BLOCKCHAIN_H
 #define MAGNACHAIN_RPC_BLOCKCHAIN_H
 
+#include "misc/amount.h"
+#include "coding/uint256.h"
+
+#include <stdint.h>
+
 class MCBlock;
 class MCBlockIndex;
+class MCCoinsView;
 class UniValue;
 
+struct MCCoinsStats
+{
+    int nHeight;
+    uint256 hashBlock;
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    uint64_t nBogoSize;
+    uint256 hashSerialized;
+    uint64_t nDiskSize;
+    MCAmount nTotalAmount;
+
+    MCCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
+};
+
 /**
  * Get the difficulty of the net wrt to the given block index, or the chain tip if
  * not provided.
@@ -34,5 +54,8 @@ UniValue mempoolToJSON(bool fVerbose = false);
 /** Block header to JSON */
 UniValue blockheaderToJSON(const MCBlockIndex* blockindex);
 
+/** Calculate statistics about the unspent transaction output set */
+bool GetUTXOStats(MCCoinsView *view, MCCoinsStats &stats);
+
 #endif
 
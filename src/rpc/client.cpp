@@ -138,6 +138,12 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "disconnectnode", 1, "nodeid" },
     //{ "getaddresscoins",0,"address" },
     { "getaddresscoins",1,"withscript" },
+    { "querycontract", 2, "args" },
+    { "querycontractbatch", 0, "calls" },
+    { "getaddressutxos", 2, "limit" },
+    { "getaddresshistory", 1, "startheight" },
+    { "getaddresshistory", 2, "endheight" },
+    { "getaddresshistory", 4, "limit" },
     // Echo with conversion (For testing only)
     { "echojson", 0, "arg0" },
     { "echojson", 1, "arg1" },
@@ -0,0 +1,306 @@
+// Copyright (c) 2016-2019 The MagnaChain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "coding/base58.h"
+#include "chain/chain.h"
+#include "rpc/blockchain.h"
+#include "rpc/server.h"
+#include "smartcontract/contractquery.h"
+#include "validation/validation.h"
+#include "utils/utilstrencodings.h"
+#include "univalue.h"
+
+#include <stdint.h>
+
+static ContractStateSnapshotRef GetQuerySnapshot(const UniValue& param)
+{
+    if (pContractQueryEngine == nullptr)
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Contract query engine is not available");
+
+    uint256 blockHash;
+    if (!param.isNull())
+        blockHash = ParseHashV(param, "blockhash");
+
+    ContractStateSnapshotRef snapshot = pContractQueryEngine->GetSnapshot(blockHash);
+    if (snapshot == nullptr)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not one of the last %u chain tips", MAX_CONTRACT_QUERY_SNAPSHOTS));
+    return snapshot;
+}
+
+static ContractQuery ParseContractQuery(const UniValue& contract, const UniValue& function, const UniValue& args, const UniValue& sender)
+{
+    ContractQuery query;
+    MagnaChainAddress contractAddr(contract.get_str());
+    if (!contractAddr.IsValid() || !contractAddr.GetContractID(query.contractId))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid contract address");
+
+    query.function = function.get_str();
+    if (query.function.empty())
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid function name");
+
+    query.args = UniValue(UniValue::VARR);
+    if (!args.isNull())
+        query.args = args.get_array();
+
+    if (!sender.isNull() && !sender.get_str().empty()) {
+        query.senderAddr.SetString(sender.get_str());
+        if (!query.senderAddr.IsValid())
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid sender address");
+    }
+    return query;
+}
+
+static UniValue ContractQueryResultToJSON(const ContractQueryResult& result)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("success", result.success));
+    if (result.success)
+        ret.push_back(Pair("return", result.ret));
+    else
+        ret.push_back(Pair("error", result.ret.size() > 0 && result.ret[0].isStr() ? result.ret[0].get_str() : std::string("unknown error")));
+    ret.push_back(Pair("cached", result.cached));
+    return ret;
+}
+
+UniValue querycontract(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 2 || request.params.size() > 5)
+        throw std::runtime_error(
+            "querycontract \"contractaddress\" \"function\" ( [args,...] \"senderaddress\" \"blockhash\" )\n"
+            "\nCall a contract function read-only against the contract state after a recent block.\n"
+            "The call never changes contract state and is not sent to the network.\n"
+            "Contract balances are not visible, functions that send coins fail.\n"
+            "\nArguments:\n"
+            "1. \"contractaddress\"   (string, required) The contract address\n"
+            "2. \"function\"          (string, required) The function to call\n"
+            "3. args                (array, optional) The function arguments\n"
+            "4. \"senderaddress\"     (string, optional) The address seen as msg.sender\n"
+            "5. \"blockhash\"         (string, optional, default=tip) One of the last chain tips to query at\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"blockhash\" : \"hash\",  (string) The block the state was taken from\n"
+            "  \"success\" : true|false, (boolean) If the call succeeded\n"
+            "  \"return\" : [...],      (array) The return values when successful\n"
+            "  \"error\" : \"msg\",       (string) The error when failed\n"
+            "  \"cached\" : true|false   (boolean) If the result came from the query cache\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("querycontract", "\"2LaZxJbTMWKsnbNtMFCZFGKp7CHAbY6yKE\" \"balanceOf\" '[\"XFbQeDS3kGYcpMnX8qHy6Nk8BjBQGrnnFg\"]'")
+            + HelpExampleRpc("querycontract", "\"2LaZxJbTMWKsnbNtMFCZFGKp7CHAbY6yKE\", \"balanceOf\", [\"XFbQeDS3kGYcpMnX8qHy6Nk8BjBQGrnnFg\"]")
+        );
+
+    ContractStateSnapshotRef snapshot = GetQuerySnapshot(request.params[4]);
+    ContractQuery query = ParseContractQuery(request.params[0], request.params[1], request.params[2], request.params[3]);
+
+    ContractQueryResult result;
+    pContractQueryEngine->Call(snapshot, query, result);
+
+    UniValue ret = ContractQueryResultToJSON(result);
+    ret.push_back(Pair("blockhash", snapshot->GetVersion().GetHex()));
+    return ret;
+}
+
+UniValue querycontractbatch(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "querycontractbatch [{\"contractaddress\":\"address\",\"function\":\"name\",\"args\":[...],\"senderaddress\":\"address\"},...] ( \"blockhash\" )\n"
+            "\nRun several read-only contract calls in parallel against the same contract state, see querycontract.\n"
+            "\nArguments:\n"
+            "1. calls               (array, required) The calls, \"args\" and \"senderaddress\" are optional\n"
+            "2. \"blockhash\"         (string, optional, default=tip) One of the last chain tips to query at\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"blockhash\" : \"hash\",  (string) The block the state was taken from\n"
+            "  \"results\" : [          (array) One entry per call in the same order, see querycontract\n"
+            "    ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("querycontractbatch", "'[{\"contractaddress\":\"2LaZxJbTMWKsnbNtMFCZFGKp7CHAbY6yKE\",\"function\":\"totalSupply\"}]'")
+            + HelpExampleRpc("querycontractbatch", "[{\"contractaddress\":\"2LaZxJbTMWKsnbNtMFCZFGKp7CHAbY6yKE\",\"function\":\"totalSupply\"}]")
+        );
+
+    ContractStateSnapshotRef snapshot = GetQuerySnapshot(request.params[1]);
+
+    const UniValue& calls = request.params[0].get_array();
+    std::vector<ContractQuery> queries;
+    queries.reserve(calls.size());
+    for (size_t i = 0; i < calls.size(); ++i) {
+        const UniValue& call = calls[i].get_obj();
+        RPCTypeCheckObj(call,
+            {
+                {"contractaddress", UniValueType(UniValue::VSTR)},
+                {"function", UniValueType(UniValue::VSTR)},
+                {"args", UniValueType(UniValue::VARR)},
+                {"senderaddress", UniValueType(UniValue::VSTR)},
+            }, true, true);
+        queries.push_back(ParseContractQuery(find_value(call, "contractaddress"), find_value(call, "function"), find_value(call, "args"), find_value(call, "senderaddress")));
+    }
+
+    std::vector<ContractQueryResult> results;
+    pContractQueryEngine->CallBatch(snapshot, queries, results);
+
+    UniValue arr(UniValue::VARR);
+    for (const ContractQueryResult& result : results)
+        arr.push_back(ContractQueryResultToJSON(result));
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("blockhash", snapshot->GetVersion().GetHex()));
+    ret.push_back(Pair("results", arr));
+    return ret;
+}
+
+static MCCoinsStats GetTipUTXOStats()
+{
+    FlushStateToDisk();
+    MCCoinsStats stats;
+    if (!GetUTXOStats(pcoinsdbview, stats))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
+    if (stats.hashBlock != chainActive.Tip()->GetBlockHash())
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "UTXO set is not at the chain tip");
+    return stats;
+}
+
+static UniValue ContractSnapshotToJSON(const ContractSnapshotHeader& header, const ContractSnapshotInfo& info, const fs::path& path)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("blockhash", header.blockHash.GetHex()));
+    ret.push_back(Pair("height", header.blockHeight));
+    ret.push_back(Pair("hash_serialized_2", header.utxoHash.GetHex()));
+    ret.push_back(Pair("contracts", info.count));
+    ret.push_back(Pair("contenthash", info.contentHash.GetHex()));
+    ret.push_back(Pair("filename", path.string()));
+    return ret;
+}
+
+static const std::string strContractSnapshotResult =
+    "{\n"
+    "  \"blockhash\" : \"hash\",         (string) The block the contract state belongs to\n"
+    "  \"height\" : n,                  (numeric) The height of the block\n"
+    "  \"hash_serialized_2\" : \"hash\", (string) The UTXO set hash at the block, see gettxoutsetinfo\n"
+    "  \"contracts\" : n,               (numeric) The number of contracts\n"
+    "  \"contenthash\" : \"hash\",       (string) The hash of the whole snapshot\n"
+    "  \"filename\" : \"file\"           (string) The snapshot file\n"
+    "}\n";
+
+UniValue dumpcontractstate(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumpcontractstate \"filename\"\n"
+            "\nWrite the contract state after the chain tip to a snapshot file.\n"
+            "The snapshot holds the code, latest data and data origin of every contract, and is paired\n"
+            "with the UTXO set of the same block. Dump at a tip deep enough to be final.\n"
+            "\nArguments:\n"
+            "1. \"filename\"    (string, required) The snapshot file, must not exist\n"
+            "\nResult:\n"
+            + strContractSnapshotResult +
+            "\nExamples:\n"
+            + HelpExampleCli("dumpcontractstate", "\"contractstate.dat\"")
+            + HelpExampleRpc("dumpcontractstate", "\"contractstate.dat\"")
+        );
+
+    fs::path path = fs::absolute(request.params[0].get_str());
+    if (fs::exists(path))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+
+    LOCK(cs_main);
+    MCCoinsStats stats = GetTipUTXOStats();
+
+    ContractSnapshotHeader header;
+    header.blockHash = chainActive.Tip()->GetBlockHash();
+    header.blockHeight = chainActive.Height();
+    header.utxoHash = stats.hashSerialized;
+
+    ContractSnapshotInfo info;
+    mpContractDb->Flush();
+    if (!mpContractDb->DumpSnapshot(path, header, chainActive.Tip(), info))
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to write contract state");
+
+    return ContractSnapshotToJSON(header, info, path);
+}
+
+UniValue loadcontractstate(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
+        throw std::runtime_error(
+            "loadcontractstate \"filename\" ( \"contenthash\" )\n"
+            "\nReplace the contract database with a snapshot written by dumpcontractstate.\n"
+            "The chain tip must be the snapshot block and the UTXO set must match the one the snapshot was paired with.\n"
+            "\nArguments:\n"
+            "1. \"filename\"    (string, required) The snapshot file\n"
+            "2. \"contenthash\" (string, optional) The expected content hash, e.g. a value committed on chain\n"
+            "\nResult:\n"
+            + strContractSnapshotResult +
+            "\nExamples:\n"
+            + HelpExampleCli("loadcontractstate", "\"contractstate.dat\"")
+            + HelpExampleRpc("loadcontractstate", "\"contractstate.dat\"")
+        );
+
+    fs::path path = fs::absolute(request.params[0].get_str());
+
+    ContractSnapshotHeader header;
+    ContractSnapshotInfo info;
+    if (!ContractDataDB::ReadSnapshotInfo(path, header, info))
+        throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Invalid contract state file");
+    if (!request.params[1].isNull() && ParseHashV(request.params[1], "contenthash") != info.contentHash)
+        throw JSONRPCError(RPC_VERIFY_ERROR, "Contract state content hash mismatch");
+
+    LOCK(cs_main);
+    if (header.blockHash != chainActive.Tip()->GetBlockHash())
+        throw JSONRPCError(RPC_VERIFY_ERROR, strprintf("Contract state is for block %s, the chain tip is %s", header.blockHash.GetHex(), chainActive.Tip()->GetBlockHash().GetHex()));
+    if (GetTipUTXOStats().hashSerialized != header.utxoHash)
+        throw JSONRPCError(RPC_VERIFY_ERROR, "UTXO set does not match the contract state");
+
+    if (!mpContractDb->LoadSnapshot(path, info.contentHash, info))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Unable to load contract state");
+    // 内存池合约依赖被清空的合约上下文，重新执行
+    UpdateContractTx(true);
+
+    return ContractSnapshotToJSON(header, info, path);
+}
+
+UniValue getcontractcacheinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getcontractcacheinfo\n"
+            "\nReturns statistics about the in-memory contract data cache.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"contracts\": n,     (numeric) The number of cached contracts\n"
+            "  \"dirty\": n,         (numeric) The number of cached contracts not yet written to disk\n"
+            "  \"usage\": n,         (numeric) The estimated memory usage of the cache in bytes\n"
+            "  \"maxusage\": n       (numeric) The cache size saved contracts are evicted down to, see -contractcache\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getcontractcacheinfo", "")
+            + HelpExampleRpc("getcontractcacheinfo", "")
+        );
+
+    ContractCacheStats stats = mpContractDb->GetCacheStats();
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("contracts", (uint64_t)stats.count));
+    ret.push_back(Pair("dirty", (uint64_t)stats.dirty));
+    ret.push_back(Pair("usage", (uint64_t)stats.usage));
+    ret.push_back(Pair("maxusage", (uint64_t)stats.maxUsage));
+    return ret;
+}
+
+static const CRPCCommand commands[] =
+{ //  category              name                         actor (function)              okSafeMode
+    //  --------------------- ------------------------     -----------------------       ----------
+    { "contract",           "querycontract",             &querycontract,               true,  {"contractaddress", "function", "args", "senderaddress", "blockhash"} },
+    { "contract",           "querycontractbatch",        &querycontractbatch,          true,  {"calls", "blockhash"} },
+    { "contract",           "dumpcontractstate",         &dumpcontractstate,           true,  {"filename"} },
+    { "contract",           "getcontractcacheinfo",      &getcontractcacheinfo,        true,  {} },
+    { "contract",           "loadcontractstate",         &loadcontractstate,           false, {"filename", "contenthash"} },
+};
+
+void RegisterContractRPCCommands(CRPCTable &t)
+{
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
+        t.appendCommand(commands[vcidx].name, &commands[vcidx]);
+}
@@ -16,6 +16,7 @@
 #include "net/protocol.h"
 #include "thread/sync.h"
 #include "misc/timedata.h"
+#include "transaction/blockencodings.h"
 #include "ui/ui_interface.h"
 #include "utils/util.h"
 #include "utils/utilstrencodings.h"
@@ -390,6 +391,42 @@ UniValue getnettotals(const JSONRPCRequest& request)
     return obj;
 }
 
+UniValue getcompactblockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 0)
+        throw std::runtime_error(
+            "getcompactblockstats\n"
+            "\nReturns how blocks received with cmpctblock were reconstructed since startup.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"blocks\": n,               (numeric) Blocks reconstructed\n"
+            "  \"contractblocks\": n,       (numeric) Blocks reconstructed with contract group layout and prev contract data\n"
+            "  \"mempoolonly\": n,          (numeric) Blocks reconstructed without requesting transactions\n"
+            "  \"failed\": n,               (numeric) Reconstructions that failed\n"
+            "  \"reconstructionrate\": x.xxx, (numeric) Share of attempts reconstructed without requesting transactions\n"
+            "  \"txprefilled\": n,          (numeric) Transactions prefilled by peers\n"
+            "  \"txmempool\": n,            (numeric) Transactions found in the mempool\n"
+            "  \"txrequested\": n           (numeric) Transactions requested with getblocktxn\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getcompactblockstats", "")
+            + HelpExampleRpc("getcompactblockstats", "")
+       );
+
+    CompactBlockStats stats = GetCompactBlockStats();
+    uint64_t nAttempts = stats.nBlocks + stats.nFailed;
+    UniValue obj(UniValue::VOBJ);
+    obj.push_back(Pair("blocks", stats.nBlocks));
+    obj.push_back(Pair("contractblocks", stats.nContractBlocks));
+    obj.push_back(Pair("mempoolonly", stats.nMempoolOnly));
+    obj.push_back(Pair("failed", stats.nFailed));
+    obj.push_back(Pair("reconstructionrate", nAttempts > 0 ? (double)stats.nMempoolOnly / nAttempts : 0.0));
+    obj.push_back(Pair("txprefilled", stats.nTxPrefilled));
+    obj.push_back(Pair("txmempool", stats.nTxMempool));
+    obj.push_back(Pair("txrequested", stats.nTxRequested));
+    return obj;
+}
+
 static UniValue GetNetworksInfo()
 {
     UniValue networks(UniValue::VARR);
@@ -633,6 +670,7 @@ static const CRPCCommand commands[] =
     { "network",            "getaddednodeinfo",       &getaddednodeinfo,       true,  {"node"} },
     { "network",            "getnettotals",           &getnettotals,           true,  {} },
     { "network",            "getnetworkinfo",         &getnetworkinfo,         true,  {} },
+    { "network",            "getcompactblockstats",   &getcompactblockstats,   true,  {} },
     { "network",            "setban",                 &setban,                 true,  {"subnet", "command", "bantime", "absolute"} },
     { "network",            "listbanned",             &listbanned,             true,  {} },
     { "network",            "clearbanned",            &clearbanned,            true,  {} },
@@ -22,6 +22,10 @@ void RegisterMiningRPCCommands(CRPCTable &tableRPC);
 void RegisterRawTransactionRPCCommands(CRPCTable &tableRPC);
 /** Register branchchain rpc commands */
 void RegisterBranchChainRPCCommands(CRPCTable &tableRPC);
+/** Register read-only contract query RPC commands */
+void RegisterContractRPCCommands(CRPCTable &tableRPC);
+/** Register address index RPC commands */
+void RegisterAddressRPCCommands(CRPCTable &tableRPC);
 
 static inline void RegisterAllCoreRPCCommands(CRPCTable &t)
 {
@@ -31,6 +35,8 @@ static inline void RegisterAllCoreRPCCommands(CRPCTable &t)
     RegisterMiningRPCCommands(t);
     RegisterRawTransactionRPCCommands(t);
 	RegisterBranchChainRPCCommands(t);
+    RegisterContractRPCCommands(t);
+    RegisterAddressRPCCommands(t);
 }
 
 #endif
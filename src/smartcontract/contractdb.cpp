@@ -6,9 +6,11 @@
 
 #include "smartcontract/contractdb.h"
 #include "coding/base58.h"
+#include "misc/memusage.h"
 #include "univalue.h"
 #include "transaction/txmempool.h"
 #include "validation/validation.h"
+#include "validation/validationinterface.h"
 #include "smartcontract/smartcontract.h"
 
 ContractDataDB* mpContractDb = nullptr;
@@ -29,6 +31,36 @@ MCAmount GetTxContractOut(const MCTransaction& tx)
     return out;
 }
 
+static MCCriticalSection cs_codePool;
+static std::map<uint256, std::weak_ptr<const std::string>> codePool;
+static size_t nCodePoolPruneSize = 1024;
+
+ContractBlob InternContractCode(const ContractBlob& code)
+{
+    if (code.empty())
+        return code;
+
+    uint256 hash = Hash(code.str().begin(), code.str().end());
+    LOCK(cs_codePool);
+    std::weak_ptr<const std::string>& ref = codePool[hash];
+    std::shared_ptr<const std::string> shared = ref.lock();
+    if (shared && *shared == code.str())
+        return ContractBlob(shared);
+    ref = code.GetRef();
+
+    // 池中记录的代码可能都已释放，数量翻倍时清理一次
+    if (codePool.size() > nCodePoolPruneSize) {
+        for (auto it = codePool.begin(); it != codePool.end();) {
+            if (it->second.expired())
+                it = codePool.erase(it);
+            else
+                ++it;
+        }
+        nCodePoolPruneSize = std::max<size_t>(1024, codePool.size() * 2);
+    }
+    return code;
+}
+
 struct CmpByBlockHeight {
     bool operator()(const uint256& bh1, const uint256& bh2) const
     {
@@ -66,6 +98,18 @@ bool ContractContext::GetData(const MCContractID& contractId, ContractInfo& cont
         return true;
     }
 
+    if (snapshot != nullptr) {
+        auto cit = snapshot->cache.find(contractId);
+        if (cit == snapshot->cache.end()) {
+            cit = snapshot->data.find(contractId);
+            if (cit == snapshot->data.end())
+                return false;
+        }
+        contractInfo.code = cit->second.code;
+        contractInfo.data = cit->second.data;
+        return true;
+    }
+
     return false;
 }
 
@@ -92,13 +136,21 @@ void ContractContext::ClearAll()
     ClearData();
 }
 
-ContractDataDB::ContractDataDB(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe)
-    : db(path, nCacheSize, fMemory, fWipe, true), threadPool(boost::thread::hardware_concurrency())
+ContractDataDB::ContractDataDB(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, size_t nMaxCacheUsage)
+    : db(path, nCacheSize, fMemory, fWipe, true), threadPool(boost::thread::hardware_concurrency()), nMaxCacheUsage(nMaxCacheUsage)
 {
     for (int i = 0; i < threadPool.size(); ++i)
         threadPool.schedule(boost::bind(InitializeThread, this));
 }
 
+ContractDataDB::~ContractDataDB()
+{
+    // 线程初始化时会访问cs_cache，需在成员析构前结束
+    threadPool.wait();
+    for (auto& it : threadId2SmartLuaState)
+        delete it.second;
+}
+
 void ContractDataDB::InitializeThread(ContractDataDB* contractDB)
 {
     {
@@ -238,10 +290,14 @@ bool ContractDataDB::RunBlockContract(MCBlock* pBlock, ContractContext* pContrac
         threadData[i].blockHeight = blockHeight;
         threadData[i].pPrevBlockIndex = pPrevBlockIndex;
         threadData[i].pCoinAmountCache = pCoinAmountCache;
-        threadPool.schedule(boost::bind(ExecutiveTransactionContractThread, this, pBlock, &threadData[i]));
         offset += pBlock->groupSize[i];
     }
-    threadPool.wait();
+    {
+        LOCK(cs_threadPool);
+        for (int i = 0; i < threadData.size(); ++i)
+            threadPool.schedule(boost::bind(ExecutiveTransactionContractThread, this, pBlock, &threadData[i]));
+        threadPool.wait();
+    }
 
     if (interrupt)
         return false;
@@ -275,19 +331,148 @@ bool ContractDataDB::RunBlockContract(MCBlock* pBlock, ContractContext* pContrac
     return true;
 }
 
+// 预执行线程共享的币数量查询，优先使用内存池叠加层，pcoinsTip不支持并发访问因此加锁
+class CoinAmountPreExecBase : public CoinAmountCacheBase
+{
+public:
+    CoinAmountPreExecBase(CoinAmountCache* pOverlay) : overlay(pOverlay) {}
+
+    MCAmount GetAmount(const uint160& key) const override
+    {
+        LOCK(cs);
+        MCAmount amount = 0;
+        if (overlay != nullptr && overlay->GetCachedAmount(key, amount))
+            return amount;
+        return db.GetAmount(key);
+    }
+
+private:
+    mutable MCCriticalSection cs;
+    CoinAmountCache* overlay;
+    CoinAmountDB db;
+};
+
+void ContractDataDB::PreExecuteContractThread(ContractDataDB* contractDB, const MCTransactionRef* ptx, int64_t timestamp, MCBlockIndex* pPrevBlockIndex, CoinAmountCacheBase* pAmountBase, ContractPreExecResult* result)
+{
+    // 线程尚未初始化时不做预执行，结果保持未执行状态，由调用者串行执行
+    auto it = contractDB->threadId2SmartLuaState.find(boost::this_thread::get_id());
+    if (it == contractDB->threadId2SmartLuaState.end())
+        return;
+
+    contractDB->PreExecuteContract(it->second, *ptx, timestamp, pPrevBlockIndex, pAmountBase, result);
+}
+
+void ContractDataDB::PreExecuteContract(SmartLuaState* sls, const MCTransactionRef& tx, int64_t timestamp, MCBlockIndex* pPrevBlockIndex, CoinAmountCacheBase* pAmountBase, ContractPreExecResult* result)
+{
+    ContractContext context;
+    context.snapshot = &contractContext;
+    CoinAmountCache coinAmountCache(pAmountBase);
+
+    try {
+        MCContractID contractId = tx->pContractData->address;
+        MagnaChainAddress contractAddr(contractId);
+        MagnaChainAddress senderAddr(tx->pContractData->sender.GetID());
+
+        UniValue ret(UniValue::VARR);
+        sls->Initialize(timestamp, pPrevBlockIndex->nHeight + 1, -1, senderAddr, &context, pPrevBlockIndex, SmartLuaState::SAVE_TYPE_CACHE, &coinAmountCache);
+        if (tx->nVersion == MCTransaction::PUBLISH_CONTRACT_VERSION)
+            result->success = PublishContract(sls, contractAddr, tx->pContractData->codeOrFunc, ret);
+        else if (tx->nVersion == MCTransaction::CALL_CONTRACT_VERSION) {
+            UniValue args;
+            args.read(tx->pContractData->args);
+            long maxCallNum = MAX_CONTRACT_CALL;
+            result->success = CallContract(sls, contractAddr, GetTxContractOut(*tx), tx->pContractData->codeOrFunc, args, maxCallNum, ret);
+        }
+
+        for (size_t i = 0; result->success && i < sls->recipients.size(); ++i) {
+            if (!tx->IsExistVout(sls->recipients[i]))
+                result->success = false;
+        }
+    }
+    catch (...) {
+        result->success = false;
+    }
+
+    result->contractOut = sls->contractOut;
+    result->contractIds = sls->contractIds;
+    if (result->success) {
+        result->cache = std::move(context.cache);
+        for (const MCContractID& id : result->contractIds) {
+            if (coinAmountCache.HasKeyInCache(id))
+                result->amounts[id] = coinAmountCache.GetAmount(id);
+        }
+    }
+    result->executed = true;
+    sls->Clear();
+}
+
+void ContractDataDB::PreExecuteContracts(const std::vector<MCTransactionRef>& vtx, MCBlockIndex* pPrevBlockIndex, CoinAmountCache* pCoinAmountCache, std::vector<ContractPreExecResult>& results)
+{
+    AssertLockHeld(cs_main);
+
+    results.clear();
+    results.resize(vtx.size());
+    if (pPrevBlockIndex == nullptr)
+        return;
+
+    // 调用者持有cs_main，线程执行期间链顶与内存池合约数据保持不变
+    int64_t timestamp = GetTime();
+    CoinAmountPreExecBase amountBase(pCoinAmountCache);
+    LOCK(cs_threadPool);
+    for (size_t i = 0; i < vtx.size(); ++i) {
+        if (vtx[i]->IsSmartContract())
+            threadPool.schedule(boost::bind(PreExecuteContractThread, this, &vtx[i], timestamp, pPrevBlockIndex, &amountBase, &results[i]));
+    }
+    threadPool.wait();
+}
+
+ContractPreExecBatch::ContractPreExecBatch(const std::vector<MCTransactionRef>& vtx, CoinAmountCache* pCoinAmountCache)
+{
+    mpContractDb->PreExecuteContracts(vtx, chainActive.Tip(), pCoinAmountCache, results);
+}
+
+ContractPreExecResult* ContractPreExecBatch::Take(size_t index)
+{
+    if (index >= results.size() || !results[index].executed)
+        return nullptr;
+
+    ContractPreExecResult& result = results[index];
+    // 预执行失败时调用过的合约可能没有记录完整，交给串行执行判断
+    if (!result.success)
+        return nullptr;
+
+    bool conflict = false;
+    for (const MCContractID& id : result.contractIds) {
+        if (written.count(id) > 0) {
+            conflict = true;
+            break;
+        }
+    }
+    MarkWritten(result.contractIds);
+    return conflict ? nullptr : &result;
+}
+
+void ContractPreExecBatch::MarkWritten(const std::set<MCContractID>& contractIds)
+{
+    written.insert(contractIds.begin(), contractIds.end());
+}
+
 void ContractDataDB::UpdateBlockContractInfo(MCBlockIndex* pBlockIndex, ContractContext* pContractContext)
 {
     if (pBlockIndex == nullptr)
         return;
 
+    // 只读查询会在其他线程读取合约缓存
+    LOCK(cs_cache);
     int blockHeight = pBlockIndex->nHeight;
     int confirmBlockHeight = blockHeight - DEFAULT_CHECKBLOCKS;
 
     if (confirmBlockHeight > 0) {
         // 遍历缓存的合约数据，清理明确是无效分叉的数据
         MCBlockIndex* newConfirmBlock = pBlockIndex->GetAncestor(confirmBlockHeight);
-        for (auto ci : contractData) {
+        for (auto& ci : contractData) {
             DBBlockContractInfo& dbBlockContractInfo = ci.second;
+            size_t oldSize = dbBlockContractInfo.data.size();
 
             DBContractList::iterator saveIt = dbBlockContractInfo.data.end();
             for (DBContractList::iterator it = dbBlockContractInfo.data.begin(); it != dbBlockContractInfo.data.end();) {
@@ -310,11 +495,14 @@ void ContractDataDB::UpdateBlockContractInfo(MCBlockIndex* pBlockIndex, Contract
                 else
                     break;
             }
+            if (dbBlockContractInfo.data.size() != oldSize)
+                UpdateCacheEntry(ci.first, true);
         }
     }
 
     // 将区块插入对应的结点中
-    for (auto ci : pContractContext->data) {
+    std::vector<std::pair<MCContractID, ContractDataFrom>> updates;
+    for (const auto& ci : pContractContext->data) {
         DBContractInfo dbContractInfo;
         dbContractInfo.from.blockHash = pBlockIndex->GetBlockHash();
         dbContractInfo.blockHeight = pBlockIndex->nHeight;
@@ -338,8 +526,17 @@ void ContractDataDB::UpdateBlockContractInfo(MCBlockIndex* pBlockIndex, Contract
             }
         }
         blockContractInfo.data.insert(insertPoint, dbContractInfo);
+        UpdateCacheEntry(ci.first, true);
+        updates.push_back(std::make_pair(ci.first, dbContractInfo.from));
     }
     pContractContext->ClearData();
+
+    // 按交易顺序通知合约状态变化
+    std::sort(updates.begin(), updates.end(), [](const std::pair<MCContractID, ContractDataFrom>& a, const std::pair<MCContractID, ContractDataFrom>& b) {
+        return a.second.txIndex < b.second.txIndex;
+    });
+    for (const auto& update : updates)
+        GetMainSignals().ContractDataUpdated(update.first, pBlockIndex, update.second.txIndex, update.second.dataHash);
 }
 
 void ContractDataDB::Flush()
@@ -347,28 +544,23 @@ void ContractDataDB::Flush()
     LOCK(cs_cache);
     LogPrint(BCLog::COINDB, "flush contract data to db");
 
-    int confirmBlockHeight = chainActive.Height() - DEFAULT_CHECKBLOCKS;
-
     std::vector<uint160> removes;
     MCDBBatch batch(db);
     size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
 
-    for (auto it : contractData) {
-        DBBlockContractInfo& dbBlockContractInfo = it.second;
+    for (auto& it : cacheEntries) {
+        if (!it.second.dirty)
+            continue;
+
+        DBBlockContractInfo& dbBlockContractInfo = contractData[it.first];
         if (dbBlockContractInfo.data.size() == 0) {
             // 该合约没有有效的数据，则判定为分叉后无效的数据，移除之
             batch.Erase(it.first);
             removes.emplace_back(it.first);
         }
         else
-            batch.Write(it.first, it.second);
-
-        // 该区块已不可逆且只剩下一笔数据，则存盘后从内存移除
-        if (dbBlockContractInfo.data.size() == 1) {
-            BlockMap::iterator mi = mapBlockIndex.find(dbBlockContractInfo.data.begin()->from.blockHash);
-            if (mi != mapBlockIndex.end() && mi->second->nHeight < confirmBlockHeight)
-                removes.emplace_back(it.first);
-        }
+            batch.Write(it.first, dbBlockContractInfo);
+        it.second.dirty = false;
 
         if (batch.SizeEstimate() > batch_size) {
             LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
@@ -380,7 +572,96 @@ void ContractDataDB::Flush()
     batch.Clear();
 
     for (uint160& contractId : removes)
-        contractData.erase(contractId);
+        EraseCacheEntry(contractId);
+    LimitCache();
+}
+
+size_t ContractDataDB::DynamicMemoryUsage() const
+{
+    LOCK(cs_cache);
+    return cacheUsage;
+}
+
+ContractCacheStats ContractDataDB::GetCacheStats() const
+{
+    LOCK(cs_cache);
+    ContractCacheStats stats;
+    stats.count = cacheEntries.size();
+    for (const auto& it : cacheEntries) {
+        if (it.second.dirty)
+            ++stats.dirty;
+    }
+    stats.usage = cacheUsage;
+    stats.maxUsage = nMaxCacheUsage;
+    return stats;
+}
+
+void ContractDataDB::UpdateCacheEntry(const MCContractID& contractId, bool modified)
+{
+    auto it = cacheEntries.find(contractId);
+    bool inserted = (it == cacheEntries.end());
+    if (inserted) {
+        cacheLru.push_front(contractId);
+        it = cacheEntries.insert(std::make_pair(contractId, ContractCacheEntry())).first;
+        it->second.lruIt = cacheLru.begin();
+    }
+    else
+        cacheLru.splice(cacheLru.begin(), cacheLru, it->second.lruIt);
+
+    if (inserted || modified) {
+        // 合约缓存、淘汰信息与LRU链表的结点，以及合约代码与各区块数据
+        const DBBlockContractInfo& dbBlockContractInfo = contractData[contractId];
+        size_t usage = memusage::IncrementalDynamicUsage(contractData) + memusage::IncrementalDynamicUsage(cacheEntries) +
+            memusage::MallocUsage(sizeof(MCContractID) + 2 * sizeof(void*)) + memusage::MallocUsage(dbBlockContractInfo.code.size());
+        for (const DBContractInfo& dbContractInfo : dbBlockContractInfo.data)
+            usage += memusage::MallocUsage(sizeof(DBContractInfo) + 2 * sizeof(void*)) + memusage::MallocUsage(dbContractInfo.data.size());
+        cacheUsage += usage - it->second.usage;
+        it->second.usage = usage;
+    }
+    if (modified)
+        it->second.dirty = true;
+}
+
+void ContractDataDB::EraseCacheEntry(const MCContractID& contractId)
+{
+    auto it = cacheEntries.find(contractId);
+    if (it != cacheEntries.end()) {
+        cacheUsage -= it->second.usage;
+        cacheLru.erase(it->second.lruIt);
+        cacheEntries.erase(it);
+    }
+    contractData.erase(contractId);
+}
+
+void ContractDataDB::LimitCache()
+{
+    // 最近使用的条目总是保留，调用者可能正在使用
+    auto it = cacheLru.end();
+    while (cacheUsage > nMaxCacheUsage && it != cacheLru.begin() && std::prev(it) != cacheLru.begin()) {
+        --it;
+        if (cacheEntries[*it].dirty)
+            continue;
+        MCContractID contractId = *it++;
+        EraseCacheEntry(contractId);
+    }
+}
+
+// 取出prevBlock所在分叉上不高于其高度的最新合约数据
+static const DBContractInfo* FindBlockContractData(const DBBlockContractInfo& dbBlockContractInfo, MCBlockIndex* prevBlock)
+{
+    int blockHeight = prevBlock->nHeight;
+    // 链表最末尾存储最高的区块
+    for (DBContractList::const_reverse_iterator it = dbBlockContractInfo.data.rbegin(); it != dbBlockContractInfo.data.rend(); ++it) {
+        if (it->blockHeight <= blockHeight) {
+            BlockMap::iterator bi = mapBlockIndex.find(it->from.blockHash);
+            assert(bi != mapBlockIndex.end());
+            MCBlockIndex* checkBlockIndex = prevBlock->GetAncestor(it->blockHeight);
+            // 找到同一分叉时
+            if (checkBlockIndex == bi->second)
+                return &(*it);
+        }
+    }
+    return nullptr;
 }
 
 int ContractDataDB::GetContractInfo(const MCContractID& contractId, ContractInfo& contractInfo, MCBlockIndex* currentPrevBlockIndex)
@@ -394,30 +675,162 @@ int ContractDataDB::GetContractInfo(const MCContractID& contractId, ContractInfo
         if (!db.Read(contractId, dbBlockContractInfo))
             return -1;
         else {
-            contractData[contractId] = dbBlockContractInfo;
-            di = contractData.find(contractId);
+            dbBlockContractInfo.code = InternContractCode(dbBlockContractInfo.code);
+            di = contractData.insert(std::make_pair(contractId, std::move(dbBlockContractInfo))).first;
+            UpdateCacheEntry(contractId, false);
+            LimitCache();
         }
     }
+    else
+        UpdateCacheEntry(contractId, false);
 
     // 遍历获取相应节点的数据
     MCBlockIndex* prevBlock = (currentPrevBlockIndex ? currentPrevBlockIndex : chainActive.Tip());
-    int blockHeight = prevBlock->nHeight;
-    // 链表最末尾存储最高的区块
-    for (DBContractList::reverse_iterator it = di->second.data.rbegin(); it != di->second.data.rend(); ++it) {
-        if (it->blockHeight <= blockHeight) {
-            BlockMap::iterator bi = mapBlockIndex.find(it->from.blockHash);
-            assert(bi != mapBlockIndex.end());
-            MCBlockIndex* checkBlockIndex = prevBlock->GetAncestor(it->blockHeight);
-            // 找到同一分叉时
-            if (checkBlockIndex == bi->second) {
-                contractInfo.from.blockHash = it->from.blockHash;
-                contractInfo.from.txIndex = it->from.txIndex;
-                contractInfo.data = it->data;
-                contractInfo.code = di->second.code;
-                return it->blockHeight;
-            }
+    const DBContractInfo* dbContractInfo = FindBlockContractData(di->second, prevBlock);
+    if (dbContractInfo == nullptr)
+        return -1;
+
+    contractInfo.from.blockHash = dbContractInfo->from.blockHash;
+    contractInfo.from.txIndex = dbContractInfo->from.txIndex;
+    contractInfo.data = dbContractInfo->data;
+    contractInfo.code = di->second.code;
+    return dbContractInfo->blockHeight;
+}
+
+bool ContractDataDB::DumpSnapshot(const fs::path& path, const ContractSnapshotHeader& header, MCBlockIndex* pBlockIndex, ContractSnapshotInfo& info)
+{
+    LOCK(cs_cache);
+
+    FILE* filestr = fsbridge::fopen(path, "wb");
+    if (!filestr)
+        return error("%s: failed to open %s", __func__, path.string());
+    MCAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+    MCHashWriter ss(SER_GETHASH, 0);
+    ss << header;
+    file << header;
+    info = ContractSnapshotInfo();
+
+    std::unique_ptr<MCDBIterator> pcursor(db.NewIterator());
+    for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+        boost::this_thread::interruption_point();
+        // 混淆密钥的key比合约ID短，读取失败时跳过
+        MCContractID contractId;
+        if (!pcursor->GetKey(contractId))
+            continue;
+
+        DBBlockContractInfo dbBlockContractInfo;
+        if (!pcursor->GetValue(dbBlockContractInfo))
+            return error("%s: unable to read contract %s", __func__, contractId.GetHex());
+
+        const DBContractInfo* dbContractInfo = FindBlockContractData(dbBlockContractInfo, pBlockIndex);
+        if (dbContractInfo == nullptr)
+            continue;
+
+        DBBlockContractInfo entry;
+        entry.code = std::move(dbBlockContractInfo.code);
+        entry.data.push_back(*dbContractInfo);
+        ss << contractId << entry;
+        file << true << contractId << entry;
+        ++info.count;
+    }
+
+    info.contentHash = ss.GetHash();
+    file << false << info.count << info.contentHash;
+    FileCommit(file.Get());
+    return true;
+}
+
+// 逐条读取快照中的合约数据并重新计算content hash，与文件末尾记录的统计不符时返回false
+template <typename Fn>
+static bool ReadContractSnapshot(const fs::path& path, ContractSnapshotHeader& header, ContractSnapshotInfo& info, Fn fn)
+{
+    FILE* filestr = fsbridge::fopen(path, "rb");
+    if (!filestr)
+        return error("%s: failed to open %s", __func__, path.string());
+    MCAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+    try {
+        file >> header;
+        if (header.version != CONTRACT_SNAPSHOT_VERSION)
+            return error("%s: unknown snapshot version %u", __func__, header.version);
+
+        MCHashWriter ss(SER_GETHASH, 0);
+        ss << header;
+        uint64_t count = 0;
+        bool more;
+        for (file >> more; more; file >> more) {
+            boost::this_thread::interruption_point();
+            MCContractID contractId;
+            DBBlockContractInfo entry;
+            file >> contractId >> entry;
+            if (entry.data.size() != 1)
+                return error("%s: invalid data of contract %s", __func__, contractId.GetHex());
+            ss << contractId << entry;
+            ++count;
+            if (!fn(contractId, entry))
+                return false;
+        }
+
+        file >> info.count >> info.contentHash;
+        if (count != info.count || ss.GetHash() != info.contentHash)
+            return error("%s: snapshot content does not match its hash", __func__);
+    }
+    catch (const std::exception& e) {
+        return error("%s: deserialize error: %s", __func__, e.what());
+    }
+    return true;
+}
+
+bool ContractDataDB::ReadSnapshotInfo(const fs::path& path, ContractSnapshotHeader& header, ContractSnapshotInfo& info)
+{
+    return ReadContractSnapshot(path, header, info, [](const MCContractID&, const DBBlockContractInfo&) { return true; });
+}
+
+bool ContractDataDB::LoadSnapshot(const fs::path& path, const uint256& contentHash, ContractSnapshotInfo& info)
+{
+    LOCK(cs_cache);
+
+    size_t batch_size = (size_t)gArgs.GetArg("-dbbatchsize", nDefaultDbBatchSize);
+    MCDBBatch batch(db);
+
+    // 先清空已有的合约数据
+    std::unique_ptr<MCDBIterator> pcursor(db.NewIterator());
+    for (pcursor->SeekToFirst(); pcursor->Valid(); pcursor->Next()) {
+        MCContractID contractId;
+        if (!pcursor->GetKey(contractId))
+            continue;
+        batch.Erase(contractId);
+        if (batch.SizeEstimate() > batch_size) {
+            db.WriteBatch(batch);
+            batch.Clear();
         }
     }
+    pcursor.reset();
+    db.WriteBatch(batch);
+    batch.Clear();
+    contractData.clear();
+    cacheEntries.clear();
+    cacheLru.clear();
+    cacheUsage = 0;
+    blockContractData.clear();
+    mapHeightHash.clear();
+    contractContext.ClearAll();
+
+    ContractSnapshotHeader header;
+    bool ret = ReadContractSnapshot(path, header, info, [&](const MCContractID& contractId, const DBBlockContractInfo& entry) {
+        batch.Write(contractId, entry);
+        if (batch.SizeEstimate() > batch_size) {
+            LogPrint(BCLog::COINDB, "Writing partial batch of %.2f MiB\n", batch.SizeEstimate() * (1.0 / 1048576.0));
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+        return true;
+    });
+    db.WriteBatch(batch, true);
 
-    return -1;
+    // 文件在校验之后被修改时，已写入的数据不完整，需要重新导入
+    if (!ret || info.contentHash != contentHash)
+        return error("%s: contract snapshot changed while loading, the contract database is incomplete", __func__);
+    return true;
 }
@@ -13,7 +13,7 @@ class DBContractInfo
 public:
     ContractDataFrom from;
     uint32_t blockHeight;
-    std::string data;
+    ContractBlob data;
 
     ADD_SERIALIZE_METHODS;
     template <typename Stream, typename Operation>
@@ -29,7 +29,7 @@ typedef std::list<DBContractInfo> DBContractList;
 class DBBlockContractInfo
 {
 public:
-    std::string code;
+    ContractBlob code;
     DBContractList data;
 
     ADD_SERIALIZE_METHODS;
@@ -40,6 +40,36 @@ public:
     }
 };
 
+static const uint32_t CONTRACT_SNAPSHOT_VERSION = 1;
+//! -contractcache default (MiB)
+static const int64_t DEFAULT_CONTRACT_CACHE = 100;
+
+// 合约状态快照文件头，新节点导入后无需从创世块回放合约交易
+class ContractSnapshotHeader
+{
+public:
+    uint32_t version = CONTRACT_SNAPSHOT_VERSION;
+    uint256 blockHash;          // 快照对应的区块
+    int32_t blockHeight = 0;
+    uint256 utxoHash;           // 同一区块UTXO集的hash(gettxoutsetinfo的hash_serialized_2)，导入时检查配对
+
+    ADD_SERIALIZE_METHODS;
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(version);
+        READWRITE(blockHash);
+        READWRITE(blockHeight);
+        READWRITE(utxoHash);
+    }
+};
+
+// 合约状态快照的统计，contentHash覆盖文件头及所有合约数据，可与链上公布的值比对
+struct ContractSnapshotInfo
+{
+    uint64_t count = 0;
+    uint256 contentHash;
+};
+
 class MCContractID;
 typedef std::map<MCContractID, DBBlockContractInfo> DBContractMap;
 typedef std::map<MCContractID, ContractInfo> CONTRACT_DATA;
@@ -60,6 +90,7 @@ public:
     CONTRACT_DATA data;
     ContractTxFinalData txFinalData;
     CONTRACT_DATA prevData;
+    const ContractContext* snapshot = nullptr;  // 只读的外部上下文快照，在cache与data之后按同样顺序查询
 
 public:
     void SetCache(const MCContractID& contractId, ContractInfo& contractInfo);
@@ -85,12 +116,42 @@ struct SmartContractThreadData
     std::set<uint256> associationTransactions;
 };
 
+// 内存池合约预执行结果，基于链顶及内存池合约数据快照并行计算
+struct ContractPreExecResult
+{
+    bool executed = false;
+    bool success = false;
+    MCAmount contractOut = 0;
+    std::set<MCContractID> contractIds;         // 执行期间调用过的合约
+    CONTRACT_DATA cache;                        // 执行成功后待提交的合约数据
+    std::map<MCContractID, MCAmount> amounts;   // 执行后相关合约的币数量
+};
+
+// 合约缓存条目的淘汰信息
+struct ContractCacheEntry
+{
+    std::list<MCContractID>::iterator lruIt;
+    size_t usage = 0;
+    bool dirty = false;     // 与数据库中的数据不一致，存盘前不能淘汰
+};
+
+struct ContractCacheStats
+{
+    size_t count = 0;
+    size_t dirty = 0;
+    size_t usage = 0;
+    size_t maxUsage = 0;
+};
+
 typedef std::map<uint256, std::vector<std::map<MCContractID, ContractInfo>>> BLOCK_CONTRACT_DATA;
 class ContractDataDB
 {
 private:
     MCDBWrapper db;
     boost::threadpool::pool threadPool;
+    // 线程池的调度与等待必须持有该锁，保证区块合约执行与内存池预执行不会交叠
+    // 锁顺序：cs_main在前，持有该锁时不能再请求cs_main
+    MCCriticalSection cs_threadPool;
     std::map<boost::thread::id, SmartLuaState*> threadId2SmartLuaState;
     mutable MCCriticalSection cs_cache;
 
@@ -99,6 +160,16 @@ private:
     BLOCK_CONTRACT_DATA blockContractData;
     std::map<int, std::vector<std::pair<uint256, bool>>> mapHeightHash;
 
+    // 合约缓存按最近使用顺序淘汰，已存盘的条目才能淘汰，超出上限的部分等待下次Flush
+    std::map<MCContractID, ContractCacheEntry> cacheEntries;
+    std::list<MCContractID> cacheLru;   // 最近使用的在前
+    size_t cacheUsage = 0;
+    size_t nMaxCacheUsage;
+
+    void UpdateCacheEntry(const MCContractID& contractId, bool modified);
+    void EraseCacheEntry(const MCContractID& contractId);
+    void LimitCache();
+
 public:
     ContractContext contractContext;
 
@@ -106,7 +177,8 @@ public:
     ContractDataDB() = delete;
     ContractDataDB(const ContractDataDB&) = delete;
     ContractDataDB& operator=(const ContractDataDB&) = delete;
-    ContractDataDB(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe);
+    ContractDataDB(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, size_t nMaxCacheUsage = DEFAULT_CONTRACT_CACHE << 20);
+    ~ContractDataDB();
     static void InitializeThread(ContractDataDB* contractDB);
 
     int GetContractInfo(const MCContractID& contractId, ContractInfo& contractInfo, MCBlockIndex* currentPrevBlockIndex);
@@ -115,11 +187,42 @@ public:
     static void ExecutiveTransactionContractThread(ContractDataDB* contractDB, MCBlock* pBlock, SmartContractThreadData* threadData);
     void ExecutiveTransactionContract(SmartLuaState* sls, MCBlock* pBlock, SmartContractThreadData* threadData);
 
+    void PreExecuteContracts(const std::vector<MCTransactionRef>& vtx, MCBlockIndex* pPrevBlockIndex, CoinAmountCache* pCoinAmountCache, std::vector<ContractPreExecResult>& results);
+    static void PreExecuteContractThread(ContractDataDB* contractDB, const MCTransactionRef* ptx, int64_t timestamp, MCBlockIndex* pPrevBlockIndex, CoinAmountCacheBase* pAmountBase, ContractPreExecResult* result);
+    void PreExecuteContract(SmartLuaState* sls, const MCTransactionRef& tx, int64_t timestamp, MCBlockIndex* pPrevBlockIndex, CoinAmountCacheBase* pAmountBase, ContractPreExecResult* result);
+
     void UpdateBlockContractInfo(MCBlockIndex* pBlockIndex, ContractContext* contractContext);
     void Flush();
+    size_t DynamicMemoryUsage() const;
+    size_t GetMaxCacheUsage() const { return nMaxCacheUsage; }
+    ContractCacheStats GetCacheStats() const;
+
+    // 导出pBlockIndex之后的合约状态，每个合约只保留该区块所在分叉上的最新数据，调用前需先Flush
+    bool DumpSnapshot(const fs::path& path, const ContractSnapshotHeader& header, MCBlockIndex* pBlockIndex, ContractSnapshotInfo& info);
+    // 读取并校验快照文件，不修改数据库
+    static bool ReadSnapshotInfo(const fs::path& path, ContractSnapshotHeader& header, ContractSnapshotInfo& info);
+    // 清空合约数据库后导入快照，contentHash与文件内容不符时返回false
+    bool LoadSnapshot(const fs::path& path, const uint256& contentHash, ContractSnapshotInfo& info);
 };
 extern ContractDataDB* mpContractDb;
 
+// 按提交顺序取出预执行结果，若涉及的合约已被批次中更早的交易修改则返回nullptr，需串行重新执行
+class ContractPreExecBatch
+{
+private:
+    std::vector<ContractPreExecResult> results;
+    std::set<MCContractID> written;
+
+public:
+    ContractPreExecBatch(const std::vector<MCTransactionRef>& vtx, CoinAmountCache* pCoinAmountCache);
+    ContractPreExecBatch(std::vector<ContractPreExecResult>&& preExecResults) : results(std::move(preExecResults)) {}
+
+    ContractPreExecResult* Take(size_t index);
+    void MarkWritten(const std::set<MCContractID>& contractIds);
+};
+
 extern MCAmount GetTxContractOut(const MCTransaction& tx);
+// 返回与code内容相同的已有代码块，相同的合约代码只保留一份
+extern ContractBlob InternContractCode(const ContractBlob& code);
 
 #endif
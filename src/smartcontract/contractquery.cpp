@@ -0,0 +1,180 @@
+// Copyright (c) 2016-2019 The MagnaChain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+#include "smartcontract/contractquery.h"
+#include "chain/chain.h"
+#include "coding/hash.h"
+#include "smartcontract/smartcontract.h"
+
+ContractQueryEngine* pContractQueryEngine = nullptr;
+
+ContractStateSnapshot::ContractStateSnapshot(const MCBlockIndex* pBlockIndex)
+    : pBlockIndex(pBlockIndex), version(pBlockIndex->GetBlockHash())
+{
+}
+
+bool ContractStateSnapshot::GetContractInfo(const MCContractID& contractId, ContractInfo& contractInfo)
+{
+    std::shared_ptr<const ContractInfo> info;
+    {
+        LOCK(cs);
+        auto it = contracts.find(contractId);
+        if (it != contracts.end()) {
+            if (it->second == nullptr)
+                return false;
+            contractInfo = *it->second;
+            return true;
+        }
+    }
+
+    // 区块之后的合约状态不会再改变，并发加载的结果相同，先到者写入即可
+    ContractInfo loadInfo;
+    if (mpContractDb->GetContractInfo(contractId, loadInfo, const_cast<MCBlockIndex*>(pBlockIndex)) >= 0)
+        info = std::make_shared<const ContractInfo>(loadInfo);
+
+    LOCK(cs);
+    auto ret = contracts.insert(std::make_pair(contractId, info));
+    if (ret.first->second == nullptr)
+        return false;
+    contractInfo = *ret.first->second;
+    return true;
+}
+
+ContractQueryEngine::ContractQueryEngine(const MCBlockIndex* pTip, int nThreads, size_t nMaxCacheSize)
+    : nMaxCacheSize(nMaxCacheSize), threadPool(nThreads > 0 ? nThreads : boost::thread::hardware_concurrency())
+{
+    if (pTip != nullptr)
+        snapshots.push_back(std::make_shared<ContractStateSnapshot>(pTip));
+}
+
+ContractQueryEngine::~ContractQueryEngine()
+{
+    threadPool.wait();
+    for (SmartLuaState* sls : freeStates)
+        delete sls;
+}
+
+void ContractQueryEngine::UpdatedBlockTip(const MCBlockIndex* pindexNew, const MCBlockIndex* pindexFork, bool fInitialDownload)
+{
+    LOCK(cs);
+    snapshots.push_back(std::make_shared<ContractStateSnapshot>(pindexNew));
+    while (snapshots.size() > MAX_CONTRACT_QUERY_SNAPSHOTS)
+        snapshots.pop_front();
+}
+
+ContractStateSnapshotRef ContractQueryEngine::GetSnapshot(const uint256& blockHash)
+{
+    LOCK(cs);
+    if (snapshots.empty())
+        return nullptr;
+    if (blockHash.IsNull())
+        return snapshots.back();
+
+    for (auto it = snapshots.rbegin(); it != snapshots.rend(); ++it) {
+        if ((*it)->GetVersion() == blockHash)
+            return *it;
+    }
+    return nullptr;
+}
+
+SmartLuaState* ContractQueryEngine::AcquireState()
+{
+    {
+        LOCK(cs);
+        if (!freeStates.empty()) {
+            SmartLuaState* sls = freeStates.back();
+            freeStates.pop_back();
+            return sls;
+        }
+    }
+    return new SmartLuaState();
+}
+
+void ContractQueryEngine::ReleaseState(SmartLuaState* sls)
+{
+    sls->Clear();
+    LOCK(cs);
+    freeStates.push_back(sls);
+}
+
+uint256 ContractQueryEngine::GetCacheKey(const ContractStateSnapshot* snapshot, const ContractQuery& query)
+{
+    MCHashWriter ss(SER_GETHASH, 0);
+    ss << query.contractId << query.senderAddr.ToString() << query.function << query.args.write() << snapshot->GetVersion();
+    return ss.GetHash();
+}
+
+void ContractQueryEngine::Execute(SmartLuaState* sls, ContractStateSnapshot* snapshot, const ContractQuery& query, ContractQueryResult& result)
+{
+    uint256 key = GetCacheKey(snapshot, query);
+    {
+        LOCK(cs);
+        auto it = resultCache.find(key);
+        if (it != resultCache.end()) {
+            result.success = it->second.first;
+            result.ret.read(it->second.second);
+            result.cached = true;
+            return;
+        }
+    }
+
+    // 以快照区块的时间和高度执行，保证同一版本的结果可以缓存
+    const MCBlockIndex* pBlockIndex = snapshot->GetBlockIndex();
+    ContractContext context;
+    CoinAmountTemp coinAmountTemp;
+    CoinAmountCache coinAmountCache(&coinAmountTemp);
+    MagnaChainAddress senderAddr = query.senderAddr;
+    MagnaChainAddress contractAddr(query.contractId);
+    result.ret = UniValue(UniValue::VARR);
+    try {
+        long maxCallNum = MAX_CONTRACT_CALL;
+        sls->Initialize(pBlockIndex->GetBlockTime(), pBlockIndex->nHeight + 1, -1, senderAddr, &context, const_cast<MCBlockIndex*>(pBlockIndex), SmartLuaState::SAVE_TYPE_NONE, &coinAmountCache);
+        sls->pStateSnapshot = snapshot;
+        result.success = CallContract(sls, contractAddr, 0, query.function, query.args, maxCallNum, result.ret);
+    }
+    catch (const std::exception& e) {
+        result.success = false;
+        result.ret = UniValue(UniValue::VARR);
+        result.ret.push_back(e.what());
+    }
+
+    LOCK(cs);
+    if (nMaxCacheSize > 0 && resultCache.insert(std::make_pair(key, std::make_pair(result.success, result.ret.write()))).second) {
+        resultCacheOrder.push_back(key);
+        while (resultCacheOrder.size() > nMaxCacheSize) {
+            resultCache.erase(resultCacheOrder.front());
+            resultCacheOrder.pop_front();
+        }
+    }
+}
+
+void ContractQueryEngine::Call(const ContractStateSnapshotRef& snapshot, const ContractQuery& query, ContractQueryResult& result)
+{
+    SmartLuaState* sls = AcquireState();
+    Execute(sls, snapshot.get(), query, result);
+    ReleaseState(sls);
+}
+
+void ContractQueryEngine::CallThread(ContractQueryEngine* engine, ContractStateSnapshot* snapshot, const ContractQuery* query, ContractQueryResult* result, CSemaphore* done)
+{
+    SmartLuaState* sls = engine->AcquireState();
+    engine->Execute(sls, snapshot, *query, *result);
+    engine->ReleaseState(sls);
+    done->post();
+}
+
+void ContractQueryEngine::CallBatch(const ContractStateSnapshotRef& snapshot, const std::vector<ContractQuery>& queries, std::vector<ContractQueryResult>& results)
+{
+    results.clear();
+    results.resize(queries.size());
+
+    // 线程池可能同时执行其他批次，用信号量只等待本批次的查询
+    CSemaphore done(0);
+    for (size_t i = 0; i < queries.size(); ++i)
+        threadPool.schedule(boost::bind(CallThread, this, snapshot.get(), &queries[i], &results[i], &done));
+    for (size_t i = 0; i < queries.size(); ++i)
+        done.wait();
+}
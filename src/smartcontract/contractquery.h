@@ -0,0 +1,89 @@
+// Copyright (c) 2016-2019 The MagnaChain Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+#ifndef CONTRACT_QUERY_H
+#define CONTRACT_QUERY_H
+
+#include "smartcontract/contractdb.h"
+#include "validation/validationinterface.h"
+#include "coding/base58.h"
+#include "univalue.h"
+
+#include <deque>
+#include <memory>
+
+class SmartLuaState;
+
+static const int DEFAULT_CONTRACT_QUERY_THREADS = 0;
+static const unsigned int DEFAULT_CONTRACT_QUERY_CACHE = 10000;
+static const unsigned int MAX_CONTRACT_QUERY_SNAPSHOTS = 16;
+
+// 某个区块之后的合约状态快照，区块hash即状态版本
+// 合约数据按需从ContractDataDB加载，加载后不再改变，可被多个查询线程共享
+class ContractStateSnapshot
+{
+public:
+    ContractStateSnapshot(const MCBlockIndex* pBlockIndex);
+
+    const uint256& GetVersion() const { return version; }
+    const MCBlockIndex* GetBlockIndex() const { return pBlockIndex; }
+    bool GetContractInfo(const MCContractID& contractId, ContractInfo& contractInfo);
+
+private:
+    const MCBlockIndex* pBlockIndex;
+    uint256 version;
+    MCCriticalSection cs;
+    std::map<MCContractID, std::shared_ptr<const ContractInfo>> contracts;   // 空指针表示该区块时合约不存在
+};
+typedef std::shared_ptr<ContractStateSnapshot> ContractStateSnapshotRef;
+
+struct ContractQuery
+{
+    MCContractID contractId;
+    MagnaChainAddress senderAddr;
+    std::string function;
+    UniValue args;
+};
+
+struct ContractQueryResult
+{
+    bool success = false;
+    bool cached = false;
+    UniValue ret;
+};
+
+// 合约只读查询引擎
+// 查询在快照上以SAVE_TYPE_NONE执行，不持有cs_main，也不读写全局ContractContext
+// 合约余额对只读查询不可见，需要转账的调用会失败
+class ContractQueryEngine : public MCValidationInterface
+{
+public:
+    ContractQueryEngine(const MCBlockIndex* pTip, int nThreads, size_t nMaxCacheSize);
+    ~ContractQueryEngine();
+
+    // 空hash表示当前链顶，只保留最近MAX_CONTRACT_QUERY_SNAPSHOTS个链顶的快照
+    ContractStateSnapshotRef GetSnapshot(const uint256& blockHash);
+    void Call(const ContractStateSnapshotRef& snapshot, const ContractQuery& query, ContractQueryResult& result);
+    void CallBatch(const ContractStateSnapshotRef& snapshot, const std::vector<ContractQuery>& queries, std::vector<ContractQueryResult>& results);
+
+protected:
+    void UpdatedBlockTip(const MCBlockIndex* pindexNew, const MCBlockIndex* pindexFork, bool fInitialDownload) override;
+
+private:
+    SmartLuaState* AcquireState();
+    void ReleaseState(SmartLuaState* sls);
+    void Execute(SmartLuaState* sls, ContractStateSnapshot* snapshot, const ContractQuery& query, ContractQueryResult& result);
+    static void CallThread(ContractQueryEngine* engine, ContractStateSnapshot* snapshot, const ContractQuery* query, ContractQueryResult* result, CSemaphore* done);
+    static uint256 GetCacheKey(const ContractStateSnapshot* snapshot, const ContractQuery& query);
+
+    MCCriticalSection cs;
+    std::vector<SmartLuaState*> freeStates;             // 空闲的lua状态池
+    std::deque<ContractStateSnapshotRef> snapshots;     // 最近链顶的快照，最新的在末尾
+    size_t nMaxCacheSize;
+    std::map<uint256, std::pair<bool, std::string>> resultCache;
+    std::deque<uint256> resultCacheOrder;               // 按插入顺序淘汰
+    boost::threadpool::pool threadPool;
+};
+extern ContractQueryEngine* pContractQueryEngine;
+
+#endif
@@ -9,6 +9,7 @@
 
 #include "coding/base58.h"
 #include "smartcontract/smartcontract.h"
+#include "smartcontract/contractquery.h"
 #include "script/standard.h"
 #include "transaction/txmempool.h"
 #include "univalue.h"
@@ -399,8 +400,8 @@ bool PublishContract(SmartLuaState* sls, MagnaChainAddress& contractAddr, const
 
         if (sls->saveType > 0) {
             contractInfo.from.txIndex = sls->txIndex;
-            contractInfo.data = data;
-            contractInfo.code = code;
+            contractInfo.data = std::move(data);
+            contractInfo.code = InternContractCode(std::move(code));
             sls->SetContractInfo(contractId, contractInfo, sls->saveType == SmartLuaState::SAVE_TYPE_CACHE);
         }
     }
@@ -474,7 +475,7 @@ bool CallContractReal(SmartLuaState* sls, MagnaChainAddress& contractAddr, const
 
         if (sls->saveType > 0) {
             contractInfo.from.txIndex = sls->txIndex;
-            contractInfo.data = data;
+            contractInfo.data = std::move(data);
             assert(sls->pCoinAmountCache->DecAmount(contractId, sls->contractOut));
             sls->SetContractInfo(contractId, contractInfo, sls->saveType == SmartLuaState::SAVE_TYPE_CACHE);
         }
@@ -719,8 +720,8 @@ lua_State* SmartLuaState::GetLuaState(MagnaChainAddress& contractAddr)
         L->userData = this;
     }
 
-    MCKeyID contractId;
-    contractAddr.GetKeyID(contractId);
+    MCContractID contractId;
+    contractAddr.GetContractID(contractId);
     contractIds.insert(contractId);
     contractAddrs.emplace_back(contractAddr);
 
@@ -749,6 +750,7 @@ void SmartLuaState::Clear()
     _pContractContext = nullptr;
     _pPrevBlockIndex = nullptr;
     pCoinAmountCache = nullptr;
+    pStateSnapshot = nullptr;
     contractDataFrom.clear();
 }
 
@@ -767,7 +769,11 @@ bool SmartLuaState::GetContractInfo(const MCContractID& contractId, ContractInfo
 
     // 直接从快照缓存中读取
     if (!_pContractContext->GetData(contractId, contractInfo)) {
-        if (mpContractDb->GetContractInfo(contractId, contractInfo, _pPrevBlockIndex) < 0)
+        if (pStateSnapshot != nullptr) {
+            if (!pStateSnapshot->GetContractInfo(contractId, contractInfo))
+                return false;
+        }
+        else if (mpContractDb->GetContractInfo(contractId, contractInfo, _pPrevBlockIndex) < 0)
             return false;
     }
 
@@ -28,6 +28,7 @@ class MCWallet;
 class MCWalletTx;
 class MagnaChainAddress;
 class MakeBranchTxUTXO;
+class ContractStateSnapshot;
 
 class SmartLuaState
 {
@@ -53,6 +54,7 @@ public:
     int _internalCallNum = 0;
     CoinAmountCache* pCoinAmountCache;
     std::map<MCContractID, ContractInfo> contractDataFrom;
+    ContractStateSnapshot* pStateSnapshot = nullptr;     // 只读查询时代替ContractDataDB读取合约数据
 
 private:
     mutable MCCriticalSection _contractCS;
@@ -118,6 +118,7 @@ public:
     uint64_t nonce;
     std::vector<uint64_t> shorttxids;
     std::vector<PrefilledTransaction> prefilledtxn;
+    BlockContractLayout contractLayout;
 
     TestHeaderAndShortIDs(const MCBlockHeaderAndShortTxIDs& orig) {
         MCDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
@@ -152,6 +153,8 @@ public:
             shorttxids[i] = (uint64_t(msb) << 32) | uint64_t(lsb);
         }
         READWRITE(prefilledtxn);
+        if (HasContractLayout(s))
+            READWRITE(contractLayout);
     }
 };
 
@@ -315,6 +318,81 @@ BOOST_AUTO_TEST_CASE(EmptyBlockRoundTripTest)
     }
 }
 
+BOOST_AUTO_TEST_CASE(ContractLayoutRoundTripTest)
+{
+    MCTxMemPool pool;
+    TestMemPoolEntryHelper entry;
+    MCBlock block(BuildBlockTestCase());
+    pool.addUnchecked(block.vtx[1]->GetHash(), entry.FromTx(*block.vtx[1]));
+    pool.addUnchecked(block.vtx[2]->GetHash(), entry.FromTx(*block.vtx[2]));
+
+    uint256 prevBlockHash = InsecureRand256();
+    block.groupSize = {1, 2};
+    block.prevContractData.resize(block.vtx.size());
+    for (int i = 0; i < 2; i++) {
+        ContractDataFrom& from = block.prevContractData[2].dataFrom[MCContractID(uint160(insecure_rand_ctx.randbytes(20)))];
+        from.blockHash = prevBlockHash;
+        from.txIndex = i == 0 ? -1 : 7;
+        from.dataHash = InsecureRand256();
+    }
+    block.prevContractData[2].coins = 5 * COIN;
+
+    // the layout is sent to peers of the new version and rebuilt into the block
+    {
+        MCBlockHeaderAndShortTxIDs shortIDs(block, true);
+        MCDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+        stream << shortIDs;
+
+        MCBlockHeaderAndShortTxIDs shortIDs2;
+        stream >> shortIDs2;
+        BOOST_CHECK(stream.empty());
+
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+        MCBlock block2;
+        std::vector<MCTransactionRef> vtx_missing;
+        BOOST_CHECK(partialBlock.FillBlock(block2, vtx_missing) == READ_STATUS_OK);
+        BOOST_CHECK(block2.groupSize == block.groupSize);
+        BOOST_CHECK_EQUAL(block2.prevContractData.size(), block.prevContractData.size());
+        MCDataStream expected(SER_NETWORK, PROTOCOL_VERSION), actual(SER_NETWORK, PROTOCOL_VERSION);
+        expected << block.prevContractData;
+        actual << block2.prevContractData;
+        BOOST_CHECK(expected.str() == actual.str());
+
+        // the shared block hash is sent once and empty entries not at all
+        MCDataStream layout(SER_NETWORK, PROTOCOL_VERSION);
+        layout << BlockContractLayout(block);
+        BOOST_CHECK(layout.size() < GetSerializeSize(block.groupSize, SER_NETWORK, PROTOCOL_VERSION) + expected.size());
+    }
+
+    // older peers get the bip152 encoding
+    {
+        MCBlockHeaderAndShortTxIDs shortIDs(block, true);
+        MCDataStream stream(SER_NETWORK, INVALID_CB_NO_BAN_VERSION);
+        stream << shortIDs;
+
+        MCBlockHeaderAndShortTxIDs shortIDs2;
+        stream >> shortIDs2;
+        BOOST_CHECK(stream.empty());
+
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs2, extra_txn) == READ_STATUS_OK);
+        MCBlock block2;
+        std::vector<MCTransactionRef> vtx_missing;
+        BOOST_CHECK(partialBlock.FillBlock(block2, vtx_missing) == READ_STATUS_OK);
+        BOOST_CHECK(block2.groupSize.empty());
+        BOOST_CHECK(block2.prevContractData.empty());
+    }
+
+    // prev contract data has to match the transactions
+    {
+        block.prevContractData.resize(2);
+        MCBlockHeaderAndShortTxIDs shortIDs(block, true);
+        PartiallyDownloadedBlock partialBlock(&pool);
+        BOOST_CHECK(partialBlock.InitData(shortIDs, extra_txn) == READ_STATUS_INVALID);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(TransactionsRequestSerializationTest) {
     BlockTransactionsRequest req1;
     req1.blockhash = InsecureRand256();
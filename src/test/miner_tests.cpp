@@ -12,8 +12,12 @@
 #include "validation/validation.h"
 #include "mining/miner.h"
 #include "policy/policy.h"
+#include "key/key.h"
 #include "key/pubkey.h"
 #include "script/standard.h"
+#include "smartcontract/contractdb.h"
+#include "smartcontract/contractquery.h"
+#include "smartcontract/smartcontract.h"
 #include "transaction/txmempool.h"
 #include "coding/uint256.h"
 #include "utils/util.h"
@@ -522,4 +526,406 @@ BOOST_AUTO_TEST_CASE(CreateNewBlock_validity)
     fCheckpointsEnabled = true;
 }
 
+static const std::string counterContractCode =
+    "function init()\n"
+    "    PersistentData = {}\n"
+    "    PersistentData.count = 0\n"
+    "end\n"
+    "function inc()\n"
+    "    PersistentData.count = PersistentData.count + 1\n"
+    "end\n";
+
+static MCTransactionRef MakeContractTx(int nVersion, const MCContractID& contractId, const MCPubKey& sender, const std::string& codeOrFunc, const MCOutPoint& prevout)
+{
+    MCMutableTransaction tx;
+    tx.nVersion = nVersion;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vout.resize(1);
+    tx.vout[0].nValue = 10000;
+    tx.vout[0].scriptPubKey = MCScript() << OP_TRUE;
+    tx.pContractData.reset(new ContractData);
+    tx.pContractData->address = contractId;
+    tx.pContractData->sender = sender;
+    tx.pContractData->codeOrFunc = codeOrFunc;
+    tx.pContractData->args = "[]";
+    tx.pContractData->amountOut = 0;
+    return MakeTransactionRef(std::move(tx));
+}
+
+// Run the contract txs one after another, the reference for the parallel paths
+static void ExecuteContractTxsSerially(const std::vector<MCTransactionRef>& vtx, ContractContext* pContext)
+{
+    SmartLuaState sls;
+    CoinAmountCache coinAmountCache(nullptr);
+    for (const MCTransactionRef& tx : vtx) {
+        MagnaChainAddress contractAddr(tx->pContractData->address);
+        MagnaChainAddress senderAddr(tx->pContractData->sender.GetID());
+        UniValue ret(UniValue::VARR);
+        sls.Initialize(GetTime(), chainActive.Height() + 1, -1, senderAddr, pContext, nullptr, SmartLuaState::SAVE_TYPE_DATA, &coinAmountCache);
+        if (tx->nVersion == MCTransaction::PUBLISH_CONTRACT_VERSION) {
+            BOOST_CHECK(PublishContract(&sls, contractAddr, tx->pContractData->codeOrFunc, ret));
+        }
+        else {
+            long maxCallNum = MAX_CONTRACT_CALL;
+            BOOST_CHECK(CallContract(&sls, contractAddr, 0, tx->pContractData->codeOrFunc, UniValue(UniValue::VARR), maxCallNum, ret));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(contract_context_snapshot)
+{
+    MCContractID idCache(uint160(ParseHex("0100000000000000000000000000000000000000")));
+    MCContractID idData(uint160(ParseHex("0200000000000000000000000000000000000000")));
+    MCContractID idMissing(uint160(ParseHex("0300000000000000000000000000000000000000")));
+
+    ContractContext base;
+    ContractInfo info;
+    info.code = "data code";
+    info.data = "data";
+    base.SetData(idCache, info);
+    info.code = "cache code";
+    info.data = "cache";
+    base.SetCache(idCache, info);
+    info.code = "data code";
+    info.data = "data only";
+    base.SetData(idData, info);
+
+    ContractContext context;
+    context.snapshot = &base;
+
+    // the snapshot is searched in the same order as GetData: cache, then data
+    ContractInfo out;
+    BOOST_CHECK(context.GetData(idCache, out));
+    BOOST_CHECK_EQUAL(out.data.str(), "cache");
+    BOOST_CHECK(context.GetData(idData, out));
+    BOOST_CHECK_EQUAL(out.data.str(), "data only");
+    BOOST_CHECK(!context.GetData(idMissing, out));
+
+    // local writes hide the snapshot and never reach it
+    info.code = "own code";
+    info.data = "own";
+    context.SetCache(idData, info);
+    BOOST_CHECK(context.GetData(idData, out));
+    BOOST_CHECK_EQUAL(out.data.str(), "own");
+    BOOST_CHECK(base.GetData(idData, out));
+    BOOST_CHECK_EQUAL(out.data.str(), "data only");
+}
+
+BOOST_AUTO_TEST_CASE(contract_preexec_batch_take)
+{
+    MCContractID idA(uint160(ParseHex("0a00000000000000000000000000000000000000")));
+    MCContractID idB(uint160(ParseHex("0b00000000000000000000000000000000000000")));
+    MCContractID idC(uint160(ParseHex("0c00000000000000000000000000000000000000")));
+
+    std::vector<ContractPreExecResult> results(6);
+    for (ContractPreExecResult& result : results) {
+        result.executed = true;
+        result.success = true;
+    }
+    results[0].contractIds = { idA };
+    results[1].contractIds = { idB };
+    results[2].contractIds = { idA, idC };    // idA was written by results[0]
+    results[3].contractIds = { idC };         // still written through results[2]
+    results[4].executed = false;              // never ran, e.g. not a contract tx
+    results[5].success = false;               // failed, may not know all its contracts
+
+    ContractPreExecBatch batch(std::move(results));
+    BOOST_CHECK(batch.Take(0) != nullptr);
+    BOOST_CHECK(batch.Take(1) != nullptr);
+    BOOST_CHECK(batch.Take(2) == nullptr);
+    BOOST_CHECK(batch.Take(3) == nullptr);
+    BOOST_CHECK(batch.Take(4) == nullptr);
+    BOOST_CHECK(batch.Take(5) == nullptr);
+    BOOST_CHECK(batch.Take(6) == nullptr);
+
+    // a contract written by a serially executed tx invalidates later results
+    std::vector<ContractPreExecResult> results2(2);
+    for (ContractPreExecResult& result : results2) {
+        result.executed = true;
+        result.success = true;
+        result.contractIds = { idB };
+    }
+    ContractPreExecBatch batch2(std::move(results2));
+    batch2.MarkWritten({ idB });
+    BOOST_CHECK(batch2.Take(0) == nullptr);
+    BOOST_CHECK(batch2.Take(1) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(contract_preexec_matches_serial)
+{
+    MCKey key;
+    key.MakeNewKey(true);
+    MCContractID contractId(uint160(ParseHex("1100000000000000000000000000000000000000")));
+
+    CoinAmountDB coinAmountDB;
+    CoinAmountCache coinAmountCache(&coinAmountDB);
+    MCTransactionRef publishTx = MakeContractTx(MCTransaction::PUBLISH_CONTRACT_VERSION, contractId, key.GetPubKey(), counterContractCode, MCOutPoint(InsecureRand256(), 0));
+    ExecuteContractTxsSerially({ publishTx }, &mpContractDb->contractContext);
+
+    std::vector<MCTransactionRef> vtx;
+    vtx.push_back(MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(publishTx->GetHash(), 0)));
+    vtx.push_back(MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(vtx[0]->GetHash(), 0)));
+
+    std::vector<ContractPreExecResult> results;
+    {
+        LOCK(cs_main);
+        mpContractDb->PreExecuteContracts(vtx, chainActive.Tip(), &coinAmountCache, results);
+    }
+    BOOST_CHECK_EQUAL(results.size(), 2);
+    BOOST_CHECK(results[0].executed && results[0].success);
+    BOOST_CHECK(results[1].executed && results[1].success);
+    BOOST_CHECK(results[0].contractIds.count(contractId) > 0);
+
+    // the first call sees the same state as a serial execution
+    ContractContext serialContext;
+    serialContext.data = mpContractDb->contractContext.data;
+    ExecuteContractTxsSerially({ vtx[0] }, &serialContext);
+    BOOST_CHECK(results[0].cache[contractId].data == serialContext.data[contractId].data);
+
+    // both ran against the same snapshot, the second has to be executed again
+    BOOST_CHECK(results[1].cache[contractId].data == results[0].cache[contractId].data);
+    ContractPreExecBatch batch(std::move(results));
+    BOOST_CHECK(batch.Take(0) != nullptr);
+    BOOST_CHECK(batch.Take(1) == nullptr);
+    mpContractDb->contractContext.ClearAll();
+}
+
+BOOST_AUTO_TEST_CASE(contract_update_mempool_preexec)
+{
+    MCKey key;
+    key.MakeNewKey(true);
+    MCContractID contractId(uint160(ParseHex("2200000000000000000000000000000000000000")));
+
+    CoinAmountDB coinAmountDB;
+    CoinAmountCache coinAmountCache(&coinAmountDB);
+    CoinAmountCache* pPrevCoinAmountCache = pCoinAmountCache;
+    pCoinAmountCache = &coinAmountCache;
+
+    // publish and publishAgain target the same address, both succeed against the
+    // snapshot, the conflict makes publishAgain run serially where it fails.
+    MCTransactionRef publishTx = MakeContractTx(MCTransaction::PUBLISH_CONTRACT_VERSION, contractId, key.GetPubKey(), counterContractCode, MCOutPoint(InsecureRand256(), 0));
+    MCTransactionRef publishAgainTx = MakeContractTx(MCTransaction::PUBLISH_CONTRACT_VERSION, contractId, key.GetPubKey(), counterContractCode + "\n", MCOutPoint(InsecureRand256(), 0));
+    MCTransactionRef callTx = MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(publishTx->GetHash(), 0));
+    MCTransactionRef callAgainTx = MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(callTx->GetHash(), 0));
+
+    TestMemPoolEntryHelper entry;
+    mempool.addUnchecked(publishTx->GetHash(), entry.Fee(50000).Time(GetTime()).FromTx(*publishTx));
+    mempool.addUnchecked(publishAgainTx->GetHash(), entry.Fee(1000).Time(GetTime()).FromTx(*publishAgainTx));
+    mempool.addUnchecked(callTx->GetHash(), entry.Fee(50000).Time(GetTime()).FromTx(*callTx));
+    mempool.addUnchecked(callAgainTx->GetHash(), entry.Fee(50000).Time(GetTime()).FromTx(*callAgainTx));
+
+    UpdateContractTx(true);
+
+    BOOST_CHECK(mempool.exists(publishTx->GetHash()));
+    BOOST_CHECK(!mempool.exists(publishAgainTx->GetHash()));
+    BOOST_CHECK(mempool.exists(callTx->GetHash()));
+    BOOST_CHECK(mempool.exists(callAgainTx->GetHash()));
+
+    ContractContext serialContext;
+    ExecuteContractTxsSerially({ publishTx, callTx, callAgainTx }, &serialContext);
+    ContractInfo parallelInfo;
+    BOOST_CHECK(mpContractDb->contractContext.GetData(contractId, parallelInfo));
+    BOOST_CHECK(parallelInfo.code == serialContext.data[contractId].code);
+    BOOST_CHECK(parallelInfo.data == serialContext.data[contractId].data);
+
+    mempool.clear();
+    mpContractDb->contractContext.ClearAll();
+    pCoinAmountCache = pPrevCoinAmountCache;
+}
+
+BOOST_AUTO_TEST_CASE(contract_query_engine)
+{
+    MCKey key;
+    key.MakeNewKey(true);
+    MCContractID contractId(uint160(ParseHex("3300000000000000000000000000000000000000")));
+    MCContractID missingId(uint160(ParseHex("3400000000000000000000000000000000000000")));
+
+    // commit a published and once called contract as the state after the tip
+    MCTransactionRef publishTx = MakeContractTx(MCTransaction::PUBLISH_CONTRACT_VERSION, contractId, key.GetPubKey(),
+        counterContractCode + "function get()\n    return PersistentData.count\nend\n", MCOutPoint(InsecureRand256(), 0));
+    MCTransactionRef callTx = MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(publishTx->GetHash(), 0));
+    ContractContext context;
+    ExecuteContractTxsSerially({ publishTx, callTx }, &context);
+    mpContractDb->UpdateBlockContractInfo(chainActive.Tip(), &context);
+
+    ContractQueryEngine engine(chainActive.Tip(), 2, 16);
+    ContractStateSnapshotRef snapshot = engine.GetSnapshot(uint256());
+    BOOST_CHECK(snapshot != nullptr);
+    BOOST_CHECK(snapshot->GetVersion() == chainActive.Tip()->GetBlockHash());
+    BOOST_CHECK(engine.GetSnapshot(InsecureRand256()) == nullptr);
+
+    ContractQuery query;
+    query.contractId = contractId;
+    query.function = "get";
+    query.args = UniValue(UniValue::VARR);
+
+    ContractQueryResult result;
+    engine.Call(snapshot, query, result);
+    BOOST_CHECK(result.success);
+    BOOST_CHECK(!result.cached);
+    BOOST_CHECK_EQUAL(result.ret.write(), "[1]");
+
+    // read-only: calling inc does not change what get returns
+    query.function = "inc";
+    engine.Call(snapshot, query, result);
+    BOOST_CHECK(result.success);
+
+    std::vector<ContractQuery> queries(3, query);
+    queries[0].function = "get";
+    queries[2].contractId = missingId;
+    std::vector<ContractQueryResult> results;
+    engine.CallBatch(snapshot, queries, results);
+    BOOST_CHECK_EQUAL(results.size(), 3);
+    BOOST_CHECK(results[0].success && results[0].cached);
+    BOOST_CHECK_EQUAL(results[0].ret.write(), "[1]");
+    BOOST_CHECK(results[1].success && results[1].cached);
+    BOOST_CHECK(!results[2].success);
+}
+
+BOOST_AUTO_TEST_CASE(contract_state_snapshot)
+{
+    MCKey key;
+    key.MakeNewKey(true);
+    MCContractID contractId(uint160(ParseHex("3500000000000000000000000000000000000000")));
+
+    MCTransactionRef publishTx = MakeContractTx(MCTransaction::PUBLISH_CONTRACT_VERSION, contractId, key.GetPubKey(), counterContractCode, MCOutPoint(InsecureRand256(), 0));
+    MCTransactionRef callTx = MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(publishTx->GetHash(), 0));
+    ContractContext context;
+    ExecuteContractTxsSerially({ publishTx, callTx }, &context);
+    mpContractDb->UpdateBlockContractInfo(chainActive.Tip(), &context);
+    mpContractDb->Flush();
+
+    ContractInfo dumpedInfo;
+    BOOST_CHECK(mpContractDb->GetContractInfo(contractId, dumpedInfo, chainActive.Tip()) >= 0);
+
+    ContractSnapshotHeader header;
+    header.blockHash = chainActive.Tip()->GetBlockHash();
+    header.blockHeight = chainActive.Height();
+    header.utxoHash = InsecureRand256();
+    ContractSnapshotInfo info;
+    fs::path path = GetDataDir() / "contractstate.dat";
+    BOOST_CHECK(mpContractDb->DumpSnapshot(path, header, chainActive.Tip(), info));
+    BOOST_CHECK_EQUAL(info.count, 1);
+
+    ContractSnapshotHeader readHeader;
+    ContractSnapshotInfo readInfo;
+    BOOST_CHECK(ContractDataDB::ReadSnapshotInfo(path, readHeader, readInfo));
+    BOOST_CHECK(readHeader.blockHash == header.blockHash);
+    BOOST_CHECK(readHeader.utxoHash == header.utxoHash);
+    BOOST_CHECK(readInfo.contentHash == info.contentHash);
+
+    // a corrupted file fails verification
+    fs::path badPath = GetDataDir() / "contractstate.bad";
+    fs::copy_file(path, badPath);
+    FILE* file = fsbridge::fopen(badPath, "r+b");
+    BOOST_CHECK(file != nullptr);
+    fseek(file, -1, SEEK_END);
+    int lastByte = fgetc(file);
+    fseek(file, -1, SEEK_END);
+    fputc(lastByte ^ 0xff, file);
+    fclose(file);
+    BOOST_CHECK(!ContractDataDB::ReadSnapshotInfo(badPath, readHeader, readInfo));
+
+    // change the state after dumping, loading restores the dumped one
+    callTx = MakeContractTx(MCTransaction::CALL_CONTRACT_VERSION, contractId, key.GetPubKey(), "inc", MCOutPoint(callTx->GetHash(), 0));
+    ExecuteContractTxsSerially({ callTx }, &context);
+    mpContractDb->UpdateBlockContractInfo(chainActive.Tip(), &context);
+    mpContractDb->Flush();
+    ContractInfo changedInfo;
+    BOOST_CHECK(mpContractDb->GetContractInfo(contractId, changedInfo, chainActive.Tip()) >= 0);
+    BOOST_CHECK(changedInfo.data != dumpedInfo.data);
+
+    BOOST_CHECK(mpContractDb->LoadSnapshot(path, info.contentHash, readInfo));
+    BOOST_CHECK_EQUAL(readInfo.count, 1);
+    ContractInfo loadedInfo;
+    BOOST_CHECK(mpContractDb->GetContractInfo(contractId, loadedInfo, chainActive.Tip()) >= 0);
+    BOOST_CHECK(loadedInfo.code == dumpedInfo.code);
+    BOOST_CHECK(loadedInfo.data == dumpedInfo.data);
+    BOOST_CHECK(loadedInfo.from.blockHash == dumpedInfo.from.blockHash);
+}
+
+BOOST_AUTO_TEST_CASE(contract_cache_eviction)
+{
+    // room for about two of the three contracts
+    ContractDataDB contractDb(GetDataDir() / "contract_cache", 1 << 20, true, false, 25000);
+
+    std::vector<MCContractID> contractIds;
+    ContractContext context;
+    for (int i = 0; i < 3; ++i) {
+        contractIds.emplace_back(uint160(ParseHex(strprintf("%02x00000000000000000000000000000000000000", 0x36 + i))));
+        ContractInfo contractInfo;
+        contractInfo.code = std::string(10000, 'a' + i);
+        contractInfo.data = "data";
+        context.SetData(contractIds.back(), contractInfo);
+    }
+    contractDb.UpdateBlockContractInfo(chainActive.Tip(), &context);
+
+    // unsaved contracts are never evicted
+    ContractCacheStats stats = contractDb.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.count, 3);
+    BOOST_CHECK_EQUAL(stats.dirty, 3);
+    BOOST_CHECK(stats.usage > stats.maxUsage);
+
+    // use the first contract so that the second one is the least recently used
+    ContractInfo contractInfo;
+    BOOST_CHECK(contractDb.GetContractInfo(contractIds[0], contractInfo, chainActive.Tip()) >= 0);
+
+    contractDb.Flush();
+    stats = contractDb.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.count, 2);
+    BOOST_CHECK_EQUAL(stats.dirty, 0);
+    BOOST_CHECK(stats.usage <= stats.maxUsage);
+    BOOST_CHECK_EQUAL(contractDb.DynamicMemoryUsage(), stats.usage);
+
+    // an evicted contract is loaded from disk again
+    BOOST_CHECK(contractDb.GetContractInfo(contractIds[1], contractInfo, chainActive.Tip()) >= 0);
+    BOOST_CHECK(contractInfo.code == std::string(10000, 'b'));
+    BOOST_CHECK(contractInfo.data == "data");
+    BOOST_CHECK(contractDb.GetCacheStats().usage <= stats.maxUsage);
+}
+
+BOOST_AUTO_TEST_CASE(contract_blob_sharing)
+{
+    // lookups hand out references to the stored code and data
+    MCContractID contractId(uint160(ParseHex("3900000000000000000000000000000000000000")));
+    ContractContext context;
+    ContractInfo info;
+    info.code = std::string(10000, 'c');
+    info.data = "data";
+    ContractInfo stored = info;
+    context.SetCache(contractId, stored);
+    ContractInfo out;
+    BOOST_CHECK(context.GetData(contractId, out));
+    BOOST_CHECK(out.code.SharesWith(info.code));
+    BOOST_CHECK(out.data.SharesWith(info.data));
+
+    // equal code is kept once while it is referenced
+    ContractBlob code1 = InternContractCode(std::string(10000, 'd'));
+    ContractBlob code2 = InternContractCode(std::string(10000, 'd'));
+    BOOST_CHECK(code1.SharesWith(code2));
+    BOOST_CHECK(!code1.SharesWith(InternContractCode(std::string(10000, 'e'))));
+
+    // contracts with the same code loaded from disk share it
+    ContractDataDB contractDb(GetDataDir() / "contract_blob", 1 << 20, true, false, 1);
+    std::vector<MCContractID> contractIds;
+    context.ClearAll();
+    for (int i = 0; i < 3; ++i) {
+        contractIds.emplace_back(uint160(ParseHex(strprintf("%02x00000000000000000000000000000000000000", 0x3a + i))));
+        info.code = std::string(10000, i < 2 ? 'f' : 'g');
+        info.data = "data";
+        context.SetData(contractIds.back(), info);
+    }
+    contractDb.UpdateBlockContractInfo(chainActive.Tip(), &context);
+    BOOST_CHECK(contractDb.GetContractInfo(contractIds[2], out, chainActive.Tip()) >= 0);
+    contractDb.Flush();
+    BOOST_CHECK_EQUAL(contractDb.GetCacheStats().count, 1);
+
+    ContractInfo out1, out2;
+    BOOST_CHECK(contractDb.GetContractInfo(contractIds[0], out1, chainActive.Tip()) >= 0);
+    BOOST_CHECK(contractDb.GetContractInfo(contractIds[1], out2, chainActive.Tip()) >= 0);
+    BOOST_CHECK(out1.code == std::string(10000, 'f'));
+    BOOST_CHECK(out1.code.SharesWith(out2.code));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,10 +5,13 @@
 
 #include "rpc/server.h"
 #include "rpc/client.h"
+#include "rpc/addressrpc.h"
 
 #include "coding/base58.h"
 #include "io/core_io.h"
 #include "net/netbase.h"
+#include "transaction/undo.h"
+#include "validation/validation.h"
 #include "univalue.h"
 
 #include "test/test_magnachain.h"
@@ -344,4 +347,96 @@ BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
     BOOST_CHECK_EQUAL(result[2].get_int(), 9);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_address_index)
+{
+    MCOutPoint cursor;
+    BOOST_CHECK(ParseAddressCursor("", cursor));
+    BOOST_CHECK(cursor.IsNull());
+    MCOutPoint outpoint(InsecureRand256(), 3);
+    BOOST_CHECK(ParseAddressCursor(AddressCursorToString(outpoint), cursor));
+    BOOST_CHECK(cursor == outpoint);
+    BOOST_CHECK(!ParseAddressCursor("00:1", cursor));
+    BOOST_CHECK(!ParseAddressCursor(outpoint.hash.ToString() + ":x", cursor));
+
+    std::string addr = MagnaChainAddress(MCKeyID(uint160(insecure_rand_ctx.randbytes(20)))).ToString();
+    UniValue r = CallRPC("getaddressbalance " + addr);
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "utxocount").get_int(), 0);
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "balance").get_real(), 0);
+    r = CallRPC("getaddressutxos " + addr);
+    BOOST_CHECK(find_value(r.get_obj(), "utxos").empty());
+    BOOST_CHECK(find_value(r.get_obj(), "nextcursor").isNull());
+    r = CallRPC("getaddressmempool " + addr);
+    BOOST_CHECK(r.empty());
+
+    BOOST_CHECK_THROW(CallRPC("getaddressbalance notanaddress"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("getaddressutxos " + addr + " badcursor"), std::runtime_error);
+    BOOST_CHECK_THROW(CallRPC("getaddressutxos " + addr + " " + AddressCursorToString(outpoint) + " 0"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(rpc_address_history)
+{
+    MCKeyID keyA(uint160(insecure_rand_ctx.randbytes(20)));
+    MCKeyID keyB(uint160(insecure_rand_ctx.randbytes(20)));
+    std::string addrA = MagnaChainAddress(keyA).ToString();
+    BOOST_CHECK_THROW(CallRPC("getaddresshistory " + addrA), std::runtime_error);
+
+    // coinbase pays A, the second transaction spends a coin of B and pays A
+    MCBlock block;
+    MCMutableTransaction coinbase;
+    coinbase.vin.resize(1);
+    coinbase.vout.resize(1);
+    coinbase.vout[0].scriptPubKey = GetScriptForDestination(keyA);
+    block.vtx.push_back(MakeTransactionRef(coinbase));
+    MCMutableTransaction spend;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = MCOutPoint(InsecureRand256(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].scriptPubKey = GetScriptForDestination(keyA);
+    block.vtx.push_back(MakeTransactionRef(spend));
+    MCBlockUndo blockundo;
+    blockundo.vtxundo.resize(1);
+    blockundo.vtxundo[0].vprevout.push_back(Coin(MCTxOut(1, GetScriptForDestination(keyB)), 1, false));
+
+    uint256 hashBlock = InsecureRand256();
+    MCBlockIndex index;
+    index.nHeight = 0;
+    index.phashBlock = &hashBlock;
+
+    AddressHistoryDB db(1 << 20, true);
+    BOOST_CHECK(db.ConnectBlock(block, blockundo, &index));
+    BOOST_CHECK(db.GetBestBlock() == hashBlock);
+
+    AddressHistoryEntries entries;
+    BOOST_CHECK(db.ReadHistory(keyA, 0, 0, -1, 10, entries));
+    BOOST_CHECK_EQUAL(entries.size(), 2U);
+    BOOST_CHECK(entries[0].second == block.vtx[0]->GetHash());
+    BOOST_CHECK(entries[1].second == block.vtx[1]->GetHash());
+    entries.clear();
+    BOOST_CHECK(db.ReadHistory(keyA, 0, 1, -1, 10, entries));
+    BOOST_CHECK_EQUAL(entries.size(), 1U);
+    entries.clear();
+    BOOST_CHECK(db.ReadHistory(keyB, 0, 0, -1, 10, entries));
+    BOOST_CHECK_EQUAL(entries.size(), 1U);
+    BOOST_CHECK_EQUAL(entries[0].first.nTxIndex, 1U);
+    entries.clear();
+    BOOST_CHECK(db.ReadHistory(keyA, 1, 0, -1, 10, entries));
+    BOOST_CHECK(entries.empty());
+
+    paddrHistoryDb = &db;
+    UniValue r = CallRPC("getaddresshistory " + addrA + " 0 0 0:0 1");
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "history").size(), 1U);
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "nextcursor").get_str(), "0:1");
+    r = CallRPC("getaddresshistory " + addrA + " 0 0 0:1");
+    BOOST_CHECK_EQUAL(find_value(r.get_obj(), "history").size(), 1U);
+    BOOST_CHECK(find_value(r.get_obj(), "nextcursor").isNull());
+    BOOST_CHECK_THROW(CallRPC("getaddresshistory " + addrA + " 0 0 badcursor"), std::runtime_error);
+    paddrHistoryDb = nullptr;
+
+    BOOST_CHECK(db.DisconnectBlock(block, blockundo, &index));
+    BOOST_CHECK(db.GetBestBlock().IsNull());
+    entries.clear();
+    BOOST_CHECK(db.ReadHistory(keyA, 0, 0, -1, 10, entries));
+    BOOST_CHECK(entries.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -19,7 +19,7 @@
 
 MCBlockHeaderAndShortTxIDs::MCBlockHeaderAndShortTxIDs(const MCBlock& block, bool fUseWTXID) :
         nonce(GetRand(std::numeric_limits<uint64_t>::max())),
-        shorttxids(block.vtx.size() - 1), prefilledtxn(1), header(block) {
+        shorttxids(block.vtx.size() - 1), prefilledtxn(1), contractLayout(block), header(block) {
     FillShortTxIDSelector();
     //TODO: Use our mempool prior to block acceptance to predictively fill more than just the coinbase
     prefilledtxn[0] = {0, block.vtx[0]};
@@ -45,6 +45,13 @@ uint64_t MCBlockHeaderAndShortTxIDs::GetShortID(const uint256& txhash) const {
     return SipHashUint256(shorttxidk0, shorttxidk1, txhash) & 0xffffffffffffL;
 }
 
+static MCCriticalSection cs_compactBlockStats;
+static CompactBlockStats compactBlockStats;
+
+CompactBlockStats GetCompactBlockStats() {
+    LOCK(cs_compactBlockStats);
+    return compactBlockStats;
+}
 
 
 ReadStatus PartiallyDownloadedBlock::InitData(const MCBlockHeaderAndShortTxIDs& cmpctblock, const std::vector<std::pair<uint256, MCTransactionRef>>& extra_txn) {
@@ -53,8 +60,12 @@ ReadStatus PartiallyDownloadedBlock::InitData(const MCBlockHeaderAndShortTxIDs&
     if (cmpctblock.shorttxids.size() + cmpctblock.prefilledtxn.size() > MAX_BLOCK_WEIGHT / MIN_SERIALIZABLE_TRANSACTION_WEIGHT)
         return READ_STATUS_INVALID;
 
+    if (!cmpctblock.contractLayout.prevContractData.empty() && cmpctblock.contractLayout.prevContractData.size() != cmpctblock.BlockTxCount())
+        return READ_STATUS_INVALID;
+
     assert(header.IsNull() && txn_available.empty());
     header = cmpctblock.header;
+    contractLayout = cmpctblock.contractLayout;
     txn_available.resize(cmpctblock.BlockTxCount());
 
     int32_t lastprefilledindex = -1;
@@ -184,23 +195,35 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(MCBlock& block, const std::vector
     size_t tx_missing_offset = 0;
     for (size_t i = 0; i < txn_available.size(); i++) {
         if (!txn_available[i]) {
-            if (vtx_missing.size() <= tx_missing_offset)
+            if (vtx_missing.size() <= tx_missing_offset) {
+                LOCK(cs_compactBlockStats);
+                compactBlockStats.nFailed++;
                 return READ_STATUS_INVALID;
+            }
             block.vtx[i] = vtx_missing[tx_missing_offset++];
         } else
             block.vtx[i] = std::move(txn_available[i]);
     }
 
+    block.groupSize = std::move(contractLayout.groupSize);
+    block.prevContractData = std::move(contractLayout.prevContractData);
+
     // Make sure we can't call FillBlock again.
     header.SetNull();
     txn_available.clear();
+    contractLayout = BlockContractLayout();
 
-    if (vtx_missing.size() != tx_missing_offset)
+    if (vtx_missing.size() != tx_missing_offset) {
+        LOCK(cs_compactBlockStats);
+        compactBlockStats.nFailed++;
         return READ_STATUS_INVALID;
+    }
 
     BranchCache branchcache(g_pBranchDb);
     MCValidationState state;
     if (!CheckBlock(block, state, Params().GetConsensus(), &branchcache)) {
+        LOCK(cs_compactBlockStats);
+        compactBlockStats.nFailed++;
         // TODO: We really want to just check merkle tree manually here,
         // but that is expensive, and CheckBlock caches a block's
         // "checked-status" (in the MCBlock?). MCBlock should be able to
@@ -210,6 +233,18 @@ ReadStatus PartiallyDownloadedBlock::FillBlock(MCBlock& block, const std::vector
         return READ_STATUS_CHECKBLOCK_FAILED;
     }
 
+    {
+        LOCK(cs_compactBlockStats);
+        compactBlockStats.nBlocks++;
+        if (!block.groupSize.empty() || !block.prevContractData.empty())
+            compactBlockStats.nContractBlocks++;
+        if (vtx_missing.empty())
+            compactBlockStats.nMempoolOnly++;
+        compactBlockStats.nTxPrefilled += prefilled_count;
+        compactBlockStats.nTxMempool += mempool_count;
+        compactBlockStats.nTxRequested += vtx_missing.size();
+    }
+
     LogPrint(BCLog::CMPCTBLOCK, "Successfully reconstructed block %s with %lu txn prefilled, %lu txn from mempool (incl at least %lu from extra pool) and %lu txn requested\n", hash.ToString(), prefilled_count, mempool_count, extra_count, vtx_missing.size());
     if (vtx_missing.size() < 5) {
         for (const auto& tx : vtx_missing) {
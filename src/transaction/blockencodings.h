@@ -6,6 +6,7 @@
 #ifndef MAGNACHAIN_BLOCK_ENCODINGS_H
 #define MAGNACHAIN_BLOCK_ENCODINGS_H
 
+#include "misc/version.h"
 #include "primitives/block.h"
 
 #include <memory>
@@ -120,6 +121,123 @@ struct PrefilledTransaction {
     }
 };
 
+// Compact encoding of MCBlock::groupSize and MCBlock::prevContractData for
+// cmpctblock. Only transactions with prev contract data are sent, as a
+// differential index like BlockTransactionsRequest, and every block hash a
+// ContractDataFrom points to is sent once and referenced by its position.
+class BlockContractLayout {
+public:
+    std::vector<uint16_t> groupSize;
+    std::vector<ContractPrevData> prevContractData;
+
+    BlockContractLayout() {}
+    BlockContractLayout(const MCBlock& block) : groupSize(block.groupSize), prevContractData(block.prevContractData) {}
+
+    bool IsNull() const { return groupSize.empty() && prevContractData.empty(); }
+
+    template <typename Stream>
+    void Serialize(Stream& s) const {
+        s << COMPACTSIZE(uint64_t(groupSize.size()));
+        for (uint16_t size : groupSize)
+            s << COMPACTSIZE(uint64_t(size));
+
+        std::vector<uint256> blockHashes;
+        std::map<uint256, uint64_t> blockHashIndex;
+        std::vector<size_t> indexes;
+        for (size_t i = 0; i < prevContractData.size(); i++) {
+            if (prevContractData[i].coins == 0 && prevContractData[i].dataFrom.empty())
+                continue;
+            indexes.push_back(i);
+            for (const auto& item : prevContractData[i].dataFrom) {
+                if (blockHashIndex.insert(std::make_pair(item.second.blockHash, blockHashes.size())).second)
+                    blockHashes.push_back(item.second.blockHash);
+            }
+        }
+
+        s << COMPACTSIZE(uint64_t(prevContractData.size()));
+        s << blockHashes;
+        s << COMPACTSIZE(uint64_t(indexes.size()));
+        for (size_t i = 0; i < indexes.size(); i++) {
+            const ContractPrevData& prevData = prevContractData[indexes[i]];
+            s << COMPACTSIZE(uint64_t(indexes[i] - (i == 0 ? 0 : (indexes[i - 1] + 1))));
+            s << VARINT(uint64_t(prevData.coins));
+            s << COMPACTSIZE(uint64_t(prevData.dataFrom.size()));
+            for (const auto& item : prevData.dataFrom) {
+                s << item.first;
+                s << COMPACTSIZE(blockHashIndex[item.second.blockHash]);
+                s << VARINT(uint32_t(item.second.txIndex));
+                s << item.second.dataHash;
+            }
+        }
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s) {
+        // cmpctblock indexes transactions with 16 bits
+        static const uint64_t nMaxTxCount = uint64_t(std::numeric_limits<uint16_t>::max()) + 1;
+
+        uint64_t count = 0;
+        s >> COMPACTSIZE(count);
+        if (count > nMaxTxCount)
+            throw std::ios_base::failure("too many contract groups");
+        groupSize.resize(count);
+        for (size_t i = 0; i < groupSize.size(); i++) {
+            uint64_t size = 0;
+            s >> COMPACTSIZE(size);
+            if (size > std::numeric_limits<uint16_t>::max())
+                throw std::ios_base::failure("group size overflowed 16 bits");
+            groupSize[i] = size;
+        }
+
+        s >> COMPACTSIZE(count);
+        if (count > nMaxTxCount)
+            throw std::ios_base::failure("too many prev contract data");
+        prevContractData.clear();
+        prevContractData.resize(count);
+        std::vector<uint256> blockHashes;
+        s >> blockHashes;
+
+        uint64_t indexes_size = 0;
+        s >> COMPACTSIZE(indexes_size);
+        uint64_t offset = 0;
+        for (uint64_t i = 0; i < indexes_size; i++) {
+            uint64_t index = 0;
+            s >> COMPACTSIZE(index);
+            index += offset;
+            if (index >= prevContractData.size())
+                throw std::ios_base::failure("prev contract data index out of range");
+            offset = index + 1;
+
+            ContractPrevData& prevData = prevContractData[index];
+            uint64_t coins = 0;
+            s >> VARINT(coins);
+            prevData.coins = coins;
+            uint64_t dataFrom_size = 0;
+            s >> COMPACTSIZE(dataFrom_size);
+            for (uint64_t j = 0; j < dataFrom_size; j++) {
+                MCContractID contractId;
+                uint64_t hashIndex = 0;
+                uint32_t txIndex = 0;
+                s >> contractId;
+                s >> COMPACTSIZE(hashIndex);
+                if (hashIndex >= blockHashes.size())
+                    throw std::ios_base::failure("prev contract block hash index out of range");
+                ContractDataFrom& from = prevData.dataFrom[contractId];
+                from.blockHash = blockHashes[hashIndex];
+                s >> VARINT(txIndex);
+                from.txIndex = txIndex;
+                s >> from.dataHash;
+            }
+        }
+    }
+};
+
+// cmpctblock of older peers has no contract layout
+template <typename Stream>
+inline bool HasContractLayout(const Stream& s) {
+    return (s.GetVersion() & ~SERIALIZE_TRANSACTION_NO_WITNESS) >= CONTRACT_CMPCT_VERSION;
+}
+
 typedef enum ReadStatus_t
 {
     READ_STATUS_OK,
@@ -142,6 +260,7 @@ private:
 protected:
     std::vector<uint64_t> shorttxids;
     std::vector<PrefilledTransaction> prefilledtxn;
+    BlockContractLayout contractLayout;
 
 public:
     MCBlockHeader header;
@@ -186,6 +305,8 @@ public:
         }
 
         READWRITE(prefilledtxn);
+        if (HasContractLayout(s))
+            READWRITE(contractLayout);
 
         if (ser_action.ForRead())
             FillShortTxIDSelector();
@@ -196,6 +317,7 @@ class PartiallyDownloadedBlock {
 protected:
     std::vector<MCTransactionRef> txn_available;
     size_t prefilled_count = 0, mempool_count = 0, extra_count = 0;
+    BlockContractLayout contractLayout;
     MCTxMemPool* pool;
 public:
     MCBlockHeader header;
@@ -207,4 +329,17 @@ public:
     ReadStatus FillBlock(MCBlock& block, const std::vector<MCTransactionRef>& vtx_missing);
 };
 
+// How cmpctblock reconstruction went since startup
+struct CompactBlockStats {
+    uint64_t nBlocks = 0;           // reconstructed blocks
+    uint64_t nContractBlocks = 0;   // reconstructed blocks with contract layout
+    uint64_t nMempoolOnly = 0;      // reconstructed without getblocktxn
+    uint64_t nFailed = 0;           // fell back to getblocktxn retry or full block
+    uint64_t nTxPrefilled = 0;
+    uint64_t nTxMempool = 0;
+    uint64_t nTxRequested = 0;
+};
+
+CompactBlockStats GetCompactBlockStats();
+
 #endif
@@ -322,6 +322,15 @@ bool CoinAmountCache::HasKeyInCache(const uint160& key) const
     return (coinAmountCache.count(key) > 0);
 }
 
+bool CoinAmountCache::GetCachedAmount(const uint160& key, MCAmount& amount) const
+{
+    auto it = coinAmountCache.find(key);
+    if (it == coinAmountCache.end())
+        return false;
+    amount = it->second;
+    return true;
+}
+
 MCAmount CoinAmountCache::GetAmount(const uint160& key)
 {
     MCAmount nValue = 0;
@@ -341,6 +350,11 @@ MCAmount CoinAmountCache::GetAmount(const uint160& key)
     return nValue;
 }
 
+void CoinAmountCache::SetAmount(const uint160& key, MCAmount amount)
+{
+    coinAmountCache[key] = amount;
+}
+
 bool CoinAmountCache::IncAmount(const uint160& key, MCAmount delta)
 {
     if (delta < 0)
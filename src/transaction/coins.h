@@ -333,10 +333,13 @@ private:
 class CoinAmountCache
 {
 public:
-    CoinAmountCache(CoinAmountCacheBase* amountBase) : base(amountBase) {}
+    CoinAmountCache(CoinAmountCacheBase* amountBase) : takeSnapshot(false), base(amountBase) {}
 
     bool HasKeyInCache(const uint160& key) const;
+    //! Read a cached amount without falling back to the base, returns false on a miss
+    bool GetCachedAmount(const uint160& key, MCAmount& amount) const;
     MCAmount GetAmount(const uint160& key);
+    void SetAmount(const uint160& key, MCAmount amount);
     bool IncAmount(const uint160& key, MCAmount delta);
     bool DecAmount(const uint160& key, MCAmount delta);
 
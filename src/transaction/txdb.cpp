@@ -19,6 +19,7 @@
 #include "primitives/block.h"
 #include "txmempool.h"
 #include "script/standard.h"
+#include "transaction/undo.h"
 
 #include <sstream>
 #include <iostream>
@@ -42,6 +43,8 @@ static const char DB_LAST_BLOCK = 'l';
 
 static const char DB_COINLIST = 'A';
 
+static const char DB_ADDRHISTORY = 'h';
+
 namespace
 {
 struct CoinEntry {
@@ -557,6 +560,11 @@ static inline bool GetCoinDest(const MCOutPoint& outpoint, const Coin& coin, MCT
         }
     }
 
+    return GetScriptCoinDest(pScript, kDest);
+}
+
+bool GetScriptCoinDest(const MCScript& pScript, MCTxDestination& kDest)
+{
     if (!ExtractDestination(pScript, kDest)) {
         opcodetype opcode;
         std::vector<unsigned char> vch;
@@ -586,6 +594,14 @@ static inline bool GetCoinDest(const MCOutPoint& outpoint, const Coin& coin, MCT
     return true;
 }
 
+bool GetScriptCoinListKey(const MCScript& script, uint160& kKey)
+{
+    MCTxDestination kDest;
+    if (!GetScriptCoinDest(script, kDest))
+        return false;
+    return boost::apply_visitor(CoinCacheVisitor(kKey), kDest);
+}
+
 void CoinListDB::ImportCoins(MCCoinsMap& mapCoins)
 {
     MCCoinListMap& map = cache;
@@ -680,3 +696,136 @@ CoinListPtr CoinListDB::GetList(const uint160& kAddr) const
     }
     return mit->second;
 }
+
+AddressHistoryDB::AddressHistoryDB(size_t nCacheSize, bool fMemory, bool fWipe) : MCDBWrapper(GetDataDir() / "addrhistory", nCacheSize, fMemory, fWipe)
+{
+    if (!Read(DB_BEST_BLOCK, hashBestBlock))
+        hashBestBlock.SetNull();
+}
+
+void AddressHistoryDB::GetBlockEntries(const MCBlock& block, const MCBlockUndo& blockundo, int nHeight, AddressHistoryEntries& entries)
+{
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const MCTransaction& tx = *block.vtx[i];
+        std::set<uint160> keys;
+        uint160 key;
+        for (const MCTxOut& out : tx.vout) {
+            if (GetScriptCoinListKey(out.scriptPubKey, key))
+                keys.insert(key);
+        }
+        // branch step 2 transactions have no spent outputs in their undo data
+        if (i > 0 && i - 1 < blockundo.vtxundo.size()) {
+            const MCTxUndo& txundo = blockundo.vtxundo[i - 1];
+            if (txundo.vprevout.size() == tx.vin.size()) {
+                for (const Coin& coin : txundo.vprevout) {
+                    if (GetScriptCoinListKey(coin.out.scriptPubKey, key))
+                        keys.insert(key);
+                }
+            }
+        }
+        if (tx.IsSmartContract() && tx.pContractData) {
+            keys.insert(tx.pContractData->address);
+            keys.insert(tx.pContractData->sender.GetID());
+        }
+
+        const uint256& txid = tx.GetHash();
+        for (const uint160& k : keys)
+            entries.push_back(std::make_pair(AddressHistoryKey(k, nHeight, i), txid));
+    }
+}
+
+bool AddressHistoryDB::ConnectBlock(const MCBlock& block, const MCBlockUndo& blockundo, const MCBlockIndex* pindex)
+{
+    AddressHistoryEntries entries;
+    GetBlockEntries(block, blockundo, pindex->nHeight, entries);
+
+    MCDBBatch batch(*this);
+    for (const auto& entry : entries)
+        batch.Write(std::make_pair(DB_ADDRHISTORY, entry.first), entry.second);
+    bool fAdvance = (pindex->pprev == nullptr) ? hashBestBlock.IsNull() : (hashBestBlock == pindex->pprev->GetBlockHash());
+    if (fAdvance)
+        batch.Write(DB_BEST_BLOCK, pindex->GetBlockHash());
+    if (!WriteBatch(batch))
+        return false;
+    if (fAdvance)
+        hashBestBlock = pindex->GetBlockHash();
+    return true;
+}
+
+bool AddressHistoryDB::DisconnectBlock(const MCBlock& block, const MCBlockUndo& blockundo, const MCBlockIndex* pindex)
+{
+    AddressHistoryEntries entries;
+    GetBlockEntries(block, blockundo, pindex->nHeight, entries);
+
+    MCDBBatch batch(*this);
+    for (const auto& entry : entries)
+        batch.Erase(std::make_pair(DB_ADDRHISTORY, entry.first));
+    uint256 hashPrev = pindex->pprev ? pindex->pprev->GetBlockHash() : uint256();
+    bool fRewind = (hashBestBlock == pindex->GetBlockHash());
+    if (fRewind)
+        batch.Write(DB_BEST_BLOCK, hashPrev);
+    if (!WriteBatch(batch))
+        return false;
+    if (fRewind)
+        hashBestBlock = hashPrev;
+    return true;
+}
+
+bool AddressHistoryDB::WriteRange(const AddressHistoryEntries& entries, const uint256& hashFrom, const uint256& hashTo)
+{
+    if (hashBestBlock != hashFrom)
+        return false;
+
+    MCDBBatch batch(*this);
+    for (const auto& entry : entries)
+        batch.Write(std::make_pair(DB_ADDRHISTORY, entry.first), entry.second);
+    batch.Write(DB_BEST_BLOCK, hashTo);
+    if (!WriteBatch(batch))
+        return false;
+    hashBestBlock = hashTo;
+    return true;
+}
+
+bool AddressHistoryDB::Wipe()
+{
+    std::unique_ptr<MCDBIterator> pcursor(NewIterator());
+    MCDBBatch batch(*this);
+    pcursor->Seek(std::make_pair(DB_ADDRHISTORY, AddressHistoryKey()));
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, AddressHistoryKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRHISTORY)
+            break;
+        batch.Erase(key);
+        if (batch.SizeEstimate() > (size_t)nDefaultDbBatchSize) {
+            if (!WriteBatch(batch))
+                return false;
+            batch.Clear();
+        }
+        pcursor->Next();
+    }
+    batch.Erase(DB_BEST_BLOCK);
+    if (!WriteBatch(batch, true))
+        return false;
+    hashBestBlock.SetNull();
+    return true;
+}
+
+bool AddressHistoryDB::ReadHistory(const uint160& addr, int nStartHeight, uint32_t nStartTxIndex, int nEndHeight, size_t nLimit, AddressHistoryEntries& entries) const
+{
+    std::unique_ptr<MCDBIterator> pcursor(const_cast<AddressHistoryDB&>(*this).NewIterator());
+    pcursor->Seek(std::make_pair(DB_ADDRHISTORY, AddressHistoryKey(addr, std::max(nStartHeight, 0), nStartTxIndex)));
+    while (pcursor->Valid() && entries.size() < nLimit) {
+        std::pair<char, AddressHistoryKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRHISTORY || key.second.addr != addr)
+            break;
+        if (nEndHeight >= 0 && key.second.nHeight > (uint32_t)nEndHeight)
+            break;
+        uint256 txid;
+        if (!pcursor->GetValue(txid))
+            return error("%s: failed to read value", __func__);
+        entries.push_back(std::make_pair(key.second, txid));
+        pcursor->Next();
+    }
+    return true;
+}
@@ -10,6 +10,7 @@
 #include "transaction/coins.h"
 #include "io/dbwrapper.h"
 #include "chain/chain.h"
+#include "script/standard.h"
 
 #include <map>
 #include <string>
@@ -178,4 +179,79 @@ public:
 	CoinListPtr GetList(const uint160& kAddr) const;
 };
 
+// coin list key of the address a script pays to, false if the script is not indexed
+bool GetScriptCoinDest(const MCScript& script, MCTxDestination& kDest);
+bool GetScriptCoinListKey(const MCScript& script, uint160& kKey);
+
+class MCBlockUndo;
+
+//! -addrhistoryindex default
+static const bool DEFAULT_ADDRHISTORYINDEX = false;
+//! Max memory allocated to the address history index cache (MiB)
+static const int64_t nMaxAddrHistoryDBCache = 64;
+
+/** Key of one address history entry. Height and tx index are stored big
+ *  endian so that a cursor walks the history of an address in chain order. */
+struct AddressHistoryKey
+{
+    uint160 addr;
+    uint32_t nHeight;
+    uint32_t nTxIndex;
+
+    AddressHistoryKey() : nHeight(0), nTxIndex(0) {}
+    AddressHistoryKey(const uint160& addrIn, uint32_t nHeightIn, uint32_t nTxIndexIn) : addr(addrIn), nHeight(nHeightIn), nTxIndex(nTxIndexIn) {}
+
+    template <typename Stream>
+    void Serialize(Stream& s) const
+    {
+        s << addr;
+        uint32_t be[2] = { htobe32(nHeight), htobe32(nTxIndex) };
+        s.write((const char*)be, sizeof(be));
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream& s)
+    {
+        s >> addr;
+        uint32_t be[2];
+        s.read((char*)be, sizeof(be));
+        nHeight = be32toh(be[0]);
+        nTxIndex = be32toh(be[1]);
+    }
+};
+
+typedef std::vector<std::pair<AddressHistoryKey, uint256> > AddressHistoryEntries;
+
+/** Access to the optional address history index (addrhistory/).
+ *  Every transaction of the active chain is recorded under each address it
+ *  pays to, spends from, calls as a contract or signs as contract sender.
+ *  The best block marker only moves when the indexed range stays contiguous
+ *  from genesis, so the background builder and ConnectBlock can both write
+ *  entries while the index catches up. All writes must hold cs_main. */
+class AddressHistoryDB : public MCDBWrapper
+{
+public:
+    AddressHistoryDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+private:
+    AddressHistoryDB(const AddressHistoryDB&);
+    void operator=(const AddressHistoryDB&);
+
+    uint256 hashBestBlock;
+
+public:
+    //! Entries of a block, blockundo supplies the scripts of the spent outputs
+    static void GetBlockEntries(const MCBlock& block, const MCBlockUndo& blockundo, int nHeight, AddressHistoryEntries& entries);
+
+    const uint256& GetBestBlock() const { return hashBestBlock; }
+    bool ConnectBlock(const MCBlock& block, const MCBlockUndo& blockundo, const MCBlockIndex* pindex);
+    bool DisconnectBlock(const MCBlock& block, const MCBlockUndo& blockundo, const MCBlockIndex* pindex);
+    //! Write the entries of blocks built in the background, moving the marker from hashFrom to hashTo
+    bool WriteRange(const AddressHistoryEntries& entries, const uint256& hashFrom, const uint256& hashTo);
+    //! Forget everything, used when the marker is not found in the block index
+    bool Wipe();
+
+    //! Entries of addr from (nStartHeight, nStartTxIndex) up to nEndHeight (-1 for all), at most nLimit of them
+    bool ReadHistory(const uint160& addr, int nStartHeight, uint32_t nStartTxIndex, int nEndHeight, size_t nLimit, AddressHistoryEntries& entries) const;
+};
+
 #endif // MAGNACHAIN_TXDB_H
@@ -55,6 +55,7 @@
 
 #include <atomic>
 #include <sstream>
+#include <thread>
 
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/join.hpp>
@@ -214,6 +215,7 @@ MCCoinsViewDB *pcoinsdbview = nullptr;
 MCCoinsViewCache *pcoinsTip = nullptr;
 MCBlockTreeDB *pblocktree = nullptr;
 CoinListDB* pcoinListDb = nullptr;
+AddressHistoryDB* paddrHistoryDb = nullptr;
 CoinAmountDB*pCoinAmountDB = nullptr;
 CoinAmountCache* pCoinAmountCache = nullptr;
 
@@ -387,8 +389,35 @@ bool CheckContractVinVout(const MCTransaction& tx, SmartLuaState* sls)
 
 SmartLuaState checkSLS;
 
-bool CheckSmartContract(const MCTransaction& tx, int saveType, MCValidationState& state, MCTxMemPoolEntry* entry, CoinAmountCache* pCoinAmountCache)
+// 应用并行预执行的结果，效果与串行执行CheckSmartContract一致
+static bool ApplyContractPreExecResult(const MCTransaction& tx, int saveType, ContractPreExecResult& result, MCTxMemPoolEntry* entry, CoinAmountCache* pCoinAmountCache)
 {
+    if (!result.success)
+        return false;
+    if (tx.nVersion == MCTransaction::CALL_CONTRACT_VERSION && entry != nullptr && tx.pContractData->amountOut != result.contractOut)
+        return false;
+
+    // SetCache/SetData会移走合约数据，结果只能应用一次
+    for (auto& item : result.cache) {
+        if (saveType == SmartLuaState::SAVE_TYPE_CACHE)
+            mpContractDb->contractContext.SetCache(item.first, item.second);
+        else if (saveType == SmartLuaState::SAVE_TYPE_DATA)
+            mpContractDb->contractContext.SetData(item.first, item.second);
+    }
+    result.cache.clear();
+    for (const auto& item : result.amounts)
+        pCoinAmountCache->SetAmount(item.first, item.second);
+
+    if (entry != nullptr)
+        entry->contractAddrs.insert(result.contractIds.begin(), result.contractIds.end());
+    return true;
+}
+
+bool CheckSmartContract(const MCTransaction& tx, int saveType, MCValidationState& state, MCTxMemPoolEntry* entry, CoinAmountCache* pCoinAmountCache, ContractPreExecResult* pPreExec = nullptr)
+{
+    if (pPreExec != nullptr)
+        return ApplyContractPreExecResult(tx, saveType, *pPreExec, entry, pCoinAmountCache);
+
     MagnaChainAddress contractAddr;
     contractAddr.Set(tx.pContractData->address);
 	MagnaChainAddress senderAddr;
@@ -399,29 +428,35 @@ bool CheckSmartContract(const MCTransaction& tx, int saveType, MCValidationState
     MCAmount amount = GetTxContractOut(tx);
 
     UniValue ret(UniValue::VARR);
-	if (tx.nVersion == MCTransaction::PUBLISH_CONTRACT_VERSION) {
-        std::string rawCode = tx.pContractData->codeOrFunc;
-        checkSLS.Initialize(GetTime(), chainActive.Height() + 1, -1, senderAddr, nullptr, nullptr, saveType, pCoinAmountCache);
-        if (PublishContract(&checkSLS, contractAddr, rawCode, ret) && CheckContractVinVout(tx, &checkSLS)) {
-            if (entry != nullptr)
-                entry->contractAddrs.insert(checkSLS.contractIds.begin(), checkSLS.contractIds.end());
-            return true;
+    try {
+        if (tx.nVersion == MCTransaction::PUBLISH_CONTRACT_VERSION) {
+            std::string rawCode = tx.pContractData->codeOrFunc;
+            checkSLS.Initialize(GetTime(), chainActive.Height() + 1, -1, senderAddr, nullptr, nullptr, saveType, pCoinAmountCache);
+            if (PublishContract(&checkSLS, contractAddr, rawCode, ret) && CheckContractVinVout(tx, &checkSLS)) {
+                if (entry != nullptr)
+                    entry->contractAddrs.insert(checkSLS.contractIds.begin(), checkSLS.contractIds.end());
+                return true;
+            }
         }
-	}
-    else if (tx.nVersion == MCTransaction::CALL_CONTRACT_VERSION) {
-        long maxCallNum = MAX_CONTRACT_CALL;
-        checkSLS.Initialize(GetTime(), chainActive.Height() + 1, -1, senderAddr, nullptr, nullptr, saveType, pCoinAmountCache);
-        if (CallContract(&checkSLS, contractAddr, amount, strFuncName, args, maxCallNum, ret) && CheckContractVinVout(tx, &checkSLS)) {
-            if (entry != nullptr) {
-                if (entry->GetTx().pContractData->amountOut != checkSLS.contractOut)
-                    return false;
-                entry->contractAddrs.insert(checkSLS.contractIds.begin(), checkSLS.contractIds.end());
+        else if (tx.nVersion == MCTransaction::CALL_CONTRACT_VERSION) {
+            long maxCallNum = MAX_CONTRACT_CALL;
+            checkSLS.Initialize(GetTime(), chainActive.Height() + 1, -1, senderAddr, nullptr, nullptr, saveType, pCoinAmountCache);
+            if (CallContract(&checkSLS, contractAddr, amount, strFuncName, args, maxCallNum, ret) && CheckContractVinVout(tx, &checkSLS)) {
+                if (entry != nullptr) {
+                    if (entry->GetTx().pContractData->amountOut != checkSLS.contractOut)
+                        return false;
+                    entry->contractAddrs.insert(checkSLS.contractIds.begin(), checkSLS.contractIds.end());
+                }
+                return true;
             }
-            return true;
         }
-	}
+    }
+    catch (const std::exception& e) {
+        // e.g. publishing to an address that already holds a contract
+        LogPrint(BCLog::MEMPOOL, "%s: %s\n", __func__, e.what());
+    }
 
-	return false;
+    return false;
 }
 
 // Returns the script flags which should be checked for a given block
@@ -483,10 +518,8 @@ void UpdateMempoolForReorg(DisconnectedBlockTransactions &disconnectpool, bool f
     // Iterate disconnectpool in reverse, so that we add transactions
     // back to the mempool starting with the earliest transaction that had
     // been previously seen in a block.
-    auto it = disconnectpool.queuedTx.get<insertion_order>().rbegin();
-    while (it != disconnectpool.queuedTx.get<insertion_order>().rend()) {
-        // ignore validation errors in resurrected transactions
-        MCValidationState stateDummy;
+    std::vector<MCTransactionRef> vResurrect;
+    for (auto it = disconnectpool.queuedTx.get<insertion_order>().rbegin(); it != disconnectpool.queuedTx.get<insertion_order>().rend(); ++it) {
         MCTransactionRef ptx = *it;
         if (fAddToMempool){
             if (ptx->IsBranchChainTransStep2() && ptx->fromBranchId != MCBaseChainParams::MAIN)// revert transaction data
@@ -495,8 +528,21 @@ void UpdateMempoolForReorg(DisconnectedBlockTransactions &disconnectpool, bool f
                 ptx = MakeTransactionRef(mtx);
             }
         }
+        vResurrect.push_back(ptx);
+    }
+
+    // Execute the smart contracts of the resurrected transactions in parallel,
+    // the results are committed in order below.
+    std::unique_ptr<MemPoolAcceptBatch> acceptBatch;
+    if (fAddToMempool)
+        acceptBatch.reset(new MemPoolAcceptBatch(mempool, vResurrect));
+
+    auto it = disconnectpool.queuedTx.get<insertion_order>().rbegin();
+    for (size_t i = 0; it != disconnectpool.queuedTx.get<insertion_order>().rend(); ++i) {
+        // ignore validation errors in resurrected transactions
+        MCValidationState stateDummy;
         if (!fAddToMempool || (*it)->IsCoinBase() || (*it)->IsStake() || (*it)->IsReportReward() // these tx are not accepted in mempool
-            || !AcceptToMemoryPool(mempool, stateDummy, ptx, false, nullptr, nullptr, true)) {
+            || !acceptBatch->Accept(i, stateDummy, false, nullptr, nullptr, true)) {
             // If the transaction doesn't make it in to the mempool, remove any
             // transactions that depend on it (which would now be orphans).
             mempool.removeRecursive(**it, MemPoolRemovalReason::REORG);
@@ -557,7 +603,8 @@ static bool CheckInputsFromMempoolAndCache(const MCTransaction& tx, MCValidation
 
 static bool AcceptToMemoryPoolWorker(const MCChainParams& chainparams, MCTxMemPool& pool, MCValidationState& state, const MCTransactionRef& ptx, bool fLimitFree,
                               bool* pfMissingInputs, int64_t nAcceptTime, std::list<MCTransactionRef>* plTxnReplaced,
-                              bool fOverrideMempoolLimit, const MCAmount& nAbsurdFee, std::vector<MCOutPoint>& coins_to_uncache, bool executeSmartContract)
+                              bool fOverrideMempoolLimit, const MCAmount& nAbsurdFee, std::vector<MCOutPoint>& coins_to_uncache, bool executeSmartContract,
+                              ContractPreExecResult* pPreExec)
 {
     const MCTransaction& tx = *ptx;
     const uint256 hash = tx.GetHash();
@@ -754,7 +801,7 @@ static bool AcceptToMemoryPoolWorker(const MCChainParams& chainparams, MCTxMemPo
                     strprintf("%d > %d", nFees, nAbsurdFee));
 
         if (tx.IsSmartContract()) {
-            if (executeSmartContract && !CheckSmartContract(tx, SmartLuaState::SAVE_TYPE_CACHE, state, &entry, pCoinAmountCache)) {
+            if (executeSmartContract && !CheckSmartContract(tx, SmartLuaState::SAVE_TYPE_CACHE, state, &entry, pCoinAmountCache, pPreExec)) {
                 mpContractDb->contractContext.ClearCache();
                 return state.DoS(0, false, REJECT_INVALID, "Invalid smart contract");
             }
@@ -1016,7 +1063,7 @@ static bool AcceptToMemoryPoolWorker(const MCChainParams& chainparams, MCTxMemPo
 /** (try to) add transaction to memory pool with a specified acceptance time **/
 static bool AcceptToMemoryPoolWithTime(const MCChainParams& chainparams, MCTxMemPool& pool, MCValidationState &state, const MCTransactionRef &tx, bool fLimitFree,
                         bool* pfMissingInputs, int64_t nAcceptTime, std::list<MCTransactionRef>* plTxnReplaced,
-                        bool fOverrideMempoolLimit, const MCAmount nAbsurdFee, bool executeSmartContract)
+                        bool fOverrideMempoolLimit, const MCAmount nAbsurdFee, bool executeSmartContract, ContractPreExecResult* pPreExec)
 {
     bool res;
     if (tx->IsBranchChainTransStep2())
@@ -1026,7 +1073,7 @@ static bool AcceptToMemoryPoolWithTime(const MCChainParams& chainparams, MCTxMem
     else
     {
         std::vector<MCOutPoint> coins_to_uncache;
-        res = AcceptToMemoryPoolWorker(chainparams, pool, state, tx, fLimitFree, pfMissingInputs, nAcceptTime, plTxnReplaced, fOverrideMempoolLimit, nAbsurdFee, coins_to_uncache, executeSmartContract);
+        res = AcceptToMemoryPoolWorker(chainparams, pool, state, tx, fLimitFree, pfMissingInputs, nAcceptTime, plTxnReplaced, fOverrideMempoolLimit, nAbsurdFee, coins_to_uncache, executeSmartContract, pPreExec);
         if (!res) {
             for (const MCOutPoint& hashTx : coins_to_uncache)
                 pcoinsTip->Uncache(hashTx);
@@ -1047,12 +1094,37 @@ int lastTimeMillis = 0;
 int lastTimeMilisCount = 0;
 bool AcceptToMemoryPool(MCTxMemPool& pool, MCValidationState &state, const MCTransactionRef &tx, bool fLimitFree,
                         bool* pfMissingInputs, std::list<MCTransactionRef>* plTxnReplaced,
-                        bool fOverrideMempoolLimit, const MCAmount nAbsurdFee, bool executeSmartContract)
+                        bool fOverrideMempoolLimit, const MCAmount nAbsurdFee, bool executeSmartContract, ContractPreExecResult* pPreExec)
 {
     const MCChainParams& chainparams = Params();
-    return AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, fLimitFree, pfMissingInputs, GetTime(), plTxnReplaced, fOverrideMempoolLimit, nAbsurdFee, executeSmartContract);
+    return AcceptToMemoryPoolWithTime(chainparams, pool, state, tx, fLimitFree, pfMissingInputs, GetTime(), plTxnReplaced, fOverrideMempoolLimit, nAbsurdFee, executeSmartContract, pPreExec);
+}
+
+MemPoolAcceptBatch::MemPoolAcceptBatch(MCTxMemPool& poolIn, const std::vector<MCTransactionRef>& vtxIn)
+    : pool(poolIn), vtx(vtxIn), contractBatch(new ContractPreExecBatch(vtx, pCoinAmountCache))
+{
 }
 
+MemPoolAcceptBatch::~MemPoolAcceptBatch()
+{
+}
+
+bool MemPoolAcceptBatch::Accept(size_t index, MCValidationState& state, bool fLimitFree, bool* pfMissingInputs, std::list<MCTransactionRef>* plTxnReplaced,
+                                bool fOverrideMempoolLimit, const MCAmount nAbsurdFee)
+{
+    AssertLockHeld(cs_main);
+    const MCTransactionRef& ptx = vtx[index];
+    ContractPreExecResult* pPreExec = contractBatch->Take(index);
+    bool ret = AcceptToMemoryPool(pool, state, ptx, fLimitFree, pfMissingInputs, plTxnReplaced, fOverrideMempoolLimit, nAbsurdFee, true, pPreExec);
+    if (ret && pPreExec == nullptr && ptx->IsSmartContract()) {
+        // executed serially, later results of the batch must not reuse what it wrote
+        LOCK(pool.cs);
+        auto it = pool.mapTx.find(ptx->GetHash());
+        if (it != pool.mapTx.end())
+            contractBatch->MarkWritten(it->contractAddrs);
+    }
+    return ret;
+}
 
 bool ReadTxDataByTxIndex(const uint256& hash, MCTransactionRef& txOut, uint256& hashBlock, bool& retflag)
 {
@@ -1853,6 +1925,114 @@ void ThreadScriptCheck() {
     scriptcheckqueue.Thread();
 }
 
+//! Number of blocks the address history builder reads before committing them
+static const int ADDRHISTORY_BUILD_CHUNK = 256;
+
+static bool ReadAddressHistoryBlock(const MCBlockIndex* pindex, const Consensus::Params& consensusParams, MCBlock& block, MCBlockUndo& blockundo)
+{
+    if (!ReadBlockFromDisk(block, pindex, consensusParams))
+        return false;
+    // the genesis block has no undo data
+    if (pindex->pprev == nullptr)
+        return true;
+    return UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash());
+}
+
+void ThreadAddressHistoryIndex()
+{
+    RenameThread("magnachain-addrhist");
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
+    // A crash can leave the index ahead of the chain state, or on a branch
+    // that is no longer active. Walk the marker back onto the active chain.
+    {
+        LOCK(cs_main);
+        while (!paddrHistoryDb->GetBestBlock().IsNull()) {
+            BlockMap::iterator mi = mapBlockIndex.find(paddrHistoryDb->GetBestBlock());
+            MCBlockIndex* pindex = (mi == mapBlockIndex.end()) ? nullptr : mi->second;
+            if (pindex && chainActive.Contains(pindex))
+                break;
+            MCBlock block;
+            MCBlockUndo blockundo;
+            if (!pindex || !ReadAddressHistoryBlock(pindex, consensusParams, block, blockundo) ||
+                !paddrHistoryDb->DisconnectBlock(block, blockundo, pindex)) {
+                LogPrintf("%s: address history index is not on the active chain, rebuilding\n", __func__);
+                if (!paddrHistoryDb->Wipe()) {
+                    LogPrintf("%s: failed to wipe the address history index\n", __func__);
+                    return;
+                }
+                break;
+            }
+        }
+    }
+
+    const int nWorkers = std::max(1, std::min(GetNumCores(), 8));
+    int64_t nLastLog = 0;
+    while (true) {
+        boost::this_thread::interruption_point();
+
+        // blocks following the marker on the active chain
+        uint256 hashFrom;
+        std::vector<const MCBlockIndex*> vChunk;
+        {
+            LOCK(cs_main);
+            hashFrom = paddrHistoryDb->GetBestBlock();
+            const MCBlockIndex* pindex = hashFrom.IsNull() ? chainActive.Genesis() : chainActive.Next(mapBlockIndex[hashFrom]);
+            while (pindex && (int)vChunk.size() < ADDRHISTORY_BUILD_CHUNK) {
+                vChunk.push_back(pindex);
+                pindex = chainActive.Next(pindex);
+            }
+        }
+        if (vChunk.empty())
+            break;
+
+        // reading and decoding the blocks is the expensive part, do it in parallel without cs_main
+        std::vector<AddressHistoryEntries> vEntries(vChunk.size());
+        std::atomic<bool> fFailed(false);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < nWorkers; w++) {
+            workers.emplace_back([&, w]() {
+                for (size_t i = w; i < vChunk.size() && !fFailed; i += nWorkers) {
+                    MCBlock block;
+                    MCBlockUndo blockundo;
+                    if (!ReadAddressHistoryBlock(vChunk[i], consensusParams, block, blockundo)) {
+                        fFailed = true;
+                        break;
+                    }
+                    AddressHistoryDB::GetBlockEntries(block, blockundo, vChunk[i]->nHeight, vEntries[i]);
+                }
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        if (fFailed) {
+            LogPrintf("%s: failed to read block data, address history index stopped at %s\n", __func__, hashFrom.ToString());
+            return;
+        }
+
+        AddressHistoryEntries entries;
+        for (AddressHistoryEntries& blockEntries : vEntries)
+            entries.insert(entries.end(), blockEntries.begin(), blockEntries.end());
+
+        {
+            LOCK(cs_main);
+            // a reorg moved the chain or the marker while we were reading, try again
+            if (!chainActive.Contains(vChunk.back()) || paddrHistoryDb->GetBestBlock() != hashFrom)
+                continue;
+            if (!paddrHistoryDb->WriteRange(entries, hashFrom, vChunk.back()->GetBlockHash())) {
+                LogPrintf("%s: failed to write the address history index\n", __func__);
+                return;
+            }
+        }
+
+        if (GetTime() - nLastLog >= 10) {
+            LogPrintf("Address history index built up to height %d\n", vChunk.back()->nHeight);
+            nLastLog = GetTime();
+        }
+    }
+    LogPrintf("Address history index is synced\n");
+}
+
 // Protected by cs_main
 VersionBitsCache versionbitscache;
 
@@ -2258,6 +2438,9 @@ static bool ConnectBlock(const MCBlock& block, MCValidationState& state, MCBlock
             return AbortNode(state, "Failed to write transaction index");
     }
 
+    if (paddrHistoryDb && !paddrHistoryDb->ConnectBlock(block, blockundo, pindex))
+        return AbortNode(state, "Failed to write address history index");
+
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -2316,8 +2499,11 @@ bool static FlushStateToDisk(const MCChainParams& chainparams, MCValidationState
                 nLastSetChain = nNow;
             }
             int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-            int64_t cacheSize = pcoinsTip->DynamicMemoryUsage();
-            int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
+            // Unsaved contract data can grow the contract cache past -contractcache, so count it with the coins cache.
+            int64_t nContractCacheUsage = mpContractDb ? mpContractDb->DynamicMemoryUsage() : 0;
+            int64_t nContractCacheMax = mpContractDb ? mpContractDb->GetMaxCacheUsage() : 0;
+            int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() + nContractCacheUsage;
+            int64_t nTotalSpace = nCoinCacheUsage + nContractCacheMax + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
             // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
             bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
             // The cache is over the limit, we have to write now.
@@ -2370,6 +2556,9 @@ bool static FlushStateToDisk(const MCChainParams& chainparams, MCValidationState
                 // Flush the chainstate (which may refer to block index entries).
                 if (!pcoinsTip->Flush())
                     return AbortNode(state, "Failed to write to coin database");
+                // Write the contract cache too, saved entries can then be evicted.
+                if (mpContractDb)
+                    mpContractDb->Flush();
                 nLastFlush = nNow;
             }
         }
@@ -2494,6 +2683,13 @@ bool static DisconnectTip(MCValidationState& state, const MCChainParams& chainpa
         if (g_pBranchDb)
             g_pBranchDb->Flush(pblock, false);
     }
+    if (paddrHistoryDb) {
+        MCBlockUndo blockUndo;
+        if (!UndoReadFromDisk(blockUndo, pindexDelete->GetUndoPos(), pindexDelete->pprev->GetBlockHash()))
+            return AbortNode(state, "Failed to read undo data");
+        if (!paddrHistoryDb->DisconnectBlock(block, blockUndo, pindexDelete))
+            return AbortNode(state, "Failed to update address history index");
+    }
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * 0.001);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(chainparams, state, FLUSH_STATE_IF_NEEDED))
@@ -3769,6 +3965,7 @@ static bool AcceptBlock(const std::shared_ptr<const MCBlock>& pblock, MCValidati
 
 void UpdateContractTx(bool checkContract)
 {
+    LOCK(cs_main);
     if (checkContract)
         mpContractDb->contractContext.ClearAll();
 
@@ -3776,12 +3973,26 @@ void UpdateContractTx(bool checkContract)
     std::vector<MCTransaction> vTxs;
     pCoinAmountCache->Clear();
     auto items = mempool.GetSortedDepthAndScore();
-    for(int i = 0; i < items.size(); ++i) {
+
+    std::unique_ptr<ContractPreExecBatch> contractBatch;
+    if (checkContract) {
+        std::vector<MCTransactionRef> vContractTxs;
+        for (auto& entry : items) {
+            if (entry->GetTx().IsSmartContract())
+                vContractTxs.push_back(entry->GetSharedTx());
+        }
+        contractBatch.reset(new ContractPreExecBatch(vContractTxs, pCoinAmountCache));
+    }
+
+    for (int i = 0, n = 0; i < items.size(); ++i) {
         MCTransaction tx = items[i]->GetTx();
         auto item = *items[i];
         if (tx.IsSmartContract()) {
-            if (checkContract && !CheckSmartContract(tx, SmartLuaState::SAVE_TYPE_DATA, state, &item, pCoinAmountCache))
+            ContractPreExecResult* pPreExec = contractBatch ? contractBatch->Take(n++) : nullptr;
+            if (checkContract && !CheckSmartContract(tx, SmartLuaState::SAVE_TYPE_DATA, state, &item, pCoinAmountCache, pPreExec))
                 vTxs.emplace_back(tx);
+            if (contractBatch && pPreExec == nullptr)
+                contractBatch->MarkWritten(item.contractAddrs);
         }
     }
 
@@ -4973,7 +5184,7 @@ bool LoadMempool(void)
             MCValidationState state;
             if (nTime + nExpiryTimeout > nNow) {
                 LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, true, nullptr, nTime, nullptr, false, 0, true);
+                AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, true, nullptr, nTime, nullptr, false, 0, true, nullptr);
                 if (state.IsValid()) {
                     ++count;
                 } else {
@@ -26,6 +26,7 @@
 #include <algorithm>
 #include <exception>
 #include <map>
+#include <memory>
 #include <set>
 #include <stdint.h>
 #include <string>
@@ -48,6 +49,8 @@ class SmartLuaState;
 struct ChainTxData;
 class BranchCache;
 class ContractContext;
+struct ContractPreExecResult;
+class ContractPreExecBatch;
 
 struct PrecomputedTransactionData;
 struct LockPoints;
@@ -249,6 +252,9 @@ bool CheckTranBranchScript(uint256 branchid, const MCScript& scriptPubKey);
  */
 bool ProcessNewBlock(const MCChainParams& chainparams, std::shared_ptr<MCBlock> pblock, ContractContext* pContractContext, bool fForceProcessing, bool* fNewBlock, bool executeContract);
 
+/** Re-execute the smart contracts in the mempool on top of the current tip and remove those that fail */
+void UpdateContractTx(bool checkContract);
+
 /**
  * Process incoming block headers.
  *
@@ -281,6 +287,8 @@ bool LoadChainTip(const MCChainParams& chainparams);
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Build the address history index for blocks connected before it was enabled */
+void ThreadAddressHistoryIndex();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -318,7 +326,26 @@ void PruneBlockFilesManual(int nManualPruneHeight);
 
 /** (try to) add transaction to memory pool
  * plTxnReplaced will be appended to with all transactions replaced from mempool **/
-bool AcceptToMemoryPool(MCTxMemPool& pool, MCValidationState& state, const MCTransactionRef& tx, bool fLimitFree, bool* pfMissingInputs, std::list<MCTransactionRef>* plTxnReplaced = nullptr, bool fOverrideMempoolLimit = false, const MCAmount nAbsurdFee = 0, bool executeSmartContract = true);
+bool AcceptToMemoryPool(MCTxMemPool& pool, MCValidationState& state, const MCTransactionRef& tx, bool fLimitFree, bool* pfMissingInputs, std::list<MCTransactionRef>* plTxnReplaced = nullptr, bool fOverrideMempoolLimit = false, const MCAmount nAbsurdFee = 0, bool executeSmartContract = true, ContractPreExecResult* pPreExec = nullptr);
+
+/** Admit a batch of transactions to the memory pool in order. The smart contracts
+ * of the batch are executed in parallel when the batch is created, and Accept
+ * reuses those results unless an earlier transaction of the batch touched the
+ * same contracts. cs_main must be held for the lifetime of the batch. **/
+class MemPoolAcceptBatch
+{
+public:
+    MemPoolAcceptBatch(MCTxMemPool& pool, const std::vector<MCTransactionRef>& vtx);
+    ~MemPoolAcceptBatch();
+
+    /** (try to) add the index-th transaction of the batch, see AcceptToMemoryPool */
+    bool Accept(size_t index, MCValidationState& state, bool fLimitFree, bool* pfMissingInputs, std::list<MCTransactionRef>* plTxnReplaced = nullptr, bool fOverrideMempoolLimit = false, const MCAmount nAbsurdFee = 0);
+
+private:
+    MCTxMemPool& pool;
+    std::vector<MCTransactionRef> vtx;
+    std::unique_ptr<ContractPreExecBatch> contractBatch;
+};
 
 bool AcceptChainTransStep2ToMemoryPool(const MCChainParams& chainparams, MCTxMemPool& pool, MCValidationState& state, const MCTransactionRef& tx, bool fLimitFree, bool* pfMissingInputs, int64_t nAcceptTime, std::list<MCTransactionRef>* plTxnReplaced, bool fOverrideMempoolLimit, const MCAmount nAbsurdFee);
 
@@ -477,6 +504,9 @@ extern MCBlockTreeDB* pblocktree;
 
 extern CoinListDB* pcoinListDb;
 
+/** Address history index, nullptr unless -addrhistoryindex is set (writes protected by cs_main) */
+extern AddressHistoryDB* paddrHistoryDb;
+
 extern CoinAmountDB* pCoinAmountDB;
 
 extern CoinAmountCache* pCoinAmountCache;
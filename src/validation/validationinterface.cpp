@@ -27,6 +27,7 @@ struct MainSignalsInstance {
     boost::signals2::signal<void (int64_t nBestBlockTime, MCConnman* connman)> Broadcast;
     boost::signals2::signal<void (const MCBlock&, const MCValidationState&)> BlockChecked;
     boost::signals2::signal<void (const MCBlockIndex *, const std::shared_ptr<const MCBlock>&)> NewPoWValidBlock;
+    boost::signals2::signal<void (const MCContractID &, const MCBlockIndex *, int32_t, const uint256 &)> ContractDataUpdated;
 
     // We are not allowed to assume the scheduler only runs in one thread,
     // but must ensure all callbacks happen in-order, so we end up creating
@@ -66,6 +67,7 @@ void RegisterValidationInterface(MCValidationInterface* pwalletIn) {
     g_signals.m_internals->Broadcast.connect(boost::bind(&MCValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
     g_signals.m_internals->BlockChecked.connect(boost::bind(&MCValidationInterface::BlockChecked, pwalletIn, _1, _2));
     g_signals.m_internals->NewPoWValidBlock.connect(boost::bind(&MCValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    g_signals.m_internals->ContractDataUpdated.connect(boost::bind(&MCValidationInterface::ContractDataUpdated, pwalletIn, _1, _2, _3, _4));
 }
 
 void UnregisterValidationInterface(MCValidationInterface* pwalletIn) {
@@ -78,6 +80,7 @@ void UnregisterValidationInterface(MCValidationInterface* pwalletIn) {
     g_signals.m_internals->BlockDisconnected.disconnect(boost::bind(&MCValidationInterface::BlockDisconnected, pwalletIn, _1));
     g_signals.m_internals->UpdatedBlockTip.disconnect(boost::bind(&MCValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
     g_signals.m_internals->NewPoWValidBlock.disconnect(boost::bind(&MCValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    g_signals.m_internals->ContractDataUpdated.disconnect(boost::bind(&MCValidationInterface::ContractDataUpdated, pwalletIn, _1, _2, _3, _4));
 }
 
 void UnregisterAllValidationInterfaces() {
@@ -90,6 +93,7 @@ void UnregisterAllValidationInterfaces() {
     g_signals.m_internals->BlockDisconnected.disconnect_all_slots();
     g_signals.m_internals->UpdatedBlockTip.disconnect_all_slots();
     g_signals.m_internals->NewPoWValidBlock.disconnect_all_slots();
+    g_signals.m_internals->ContractDataUpdated.disconnect_all_slots();
 }
 
 void MCMainSignals::UpdatedBlockTip(const MCBlockIndex *pindexNew, const MCBlockIndex *pindexFork, bool fInitialDownload) {
@@ -127,3 +131,7 @@ void MCMainSignals::BlockChecked(const MCBlock& block, const MCValidationState&
 void MCMainSignals::NewPoWValidBlock(const MCBlockIndex *pindex, const std::shared_ptr<const MCBlock> &block) {
     m_internals->NewPoWValidBlock(pindex, block);
 }
+
+void MCMainSignals::ContractDataUpdated(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash) {
+    m_internals->ContractDataUpdated(contractId, pindex, txIndex, dataHash);
+}
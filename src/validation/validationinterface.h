@@ -16,6 +16,7 @@ class MCBlockIndex;
 struct MCBlockLocator;
 class MCBlockIndex;
 class MCConnman;
+class MCContractID;
 class CReserveScript;
 class MCValidationInterface;
 class MCValidationState;
@@ -61,6 +62,11 @@ protected:
      * Notifies listeners that a block which builds directly on our current tip
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const MCBlockIndex *pindex, const std::shared_ptr<const MCBlock>& block) {};
+    /**
+     * Notifies listeners of the contract data written by a connected block,
+     * once per contract and in the order of the block transactions. dataHash
+     * commits to the contract code and its new data. */
+    virtual void ContractDataUpdated(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash) {}
     friend void ::RegisterValidationInterface(MCValidationInterface*);
     friend void ::UnregisterValidationInterface(MCValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
@@ -92,6 +98,7 @@ public:
     void Broadcast(int64_t nBestBlockTime, MCConnman* connman);
     void BlockChecked(const MCBlock&, const MCValidationState&);
     void NewPoWValidBlock(const MCBlockIndex *, const std::shared_ptr<const MCBlock>&);
+    void ContractDataUpdated(const MCContractID &, const MCBlockIndex *, int32_t, const uint256 &);
 };
 
 MCMainSignals& GetMainSignals();
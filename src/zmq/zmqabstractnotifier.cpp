@@ -21,3 +21,13 @@ bool CZMQAbstractNotifier::NotifyTransaction(const MCTransaction &/*transaction*
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBlockTransaction(const MCTransaction &/*transaction*/, const MCBlockIndex * /*pindex*/, int32_t /*txIndex*/)
+{
+    return true;
+}
+
+bool CZMQAbstractNotifier::NotifyContractData(const MCContractID &/*contractId*/, const MCBlockIndex * /*pindex*/, int32_t /*txIndex*/, const uint256 &/*dataHash*/)
+{
+    return true;
+}
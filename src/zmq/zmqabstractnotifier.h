@@ -35,6 +35,8 @@ public:
 
     virtual bool NotifyBlock(const MCBlockIndex *pindex);
     virtual bool NotifyTransaction(const MCTransaction &transaction);
+    virtual bool NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex);
+    virtual bool NotifyContractData(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash);
 
 protected:
     void *psocket;
@@ -40,6 +40,11 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubcontractdata"] = CZMQAbstractNotifier::Create<CZMQPublishContractDataNotifier>;
+    factories["pubcontractpublish"] = CZMQAbstractNotifier::Create<CZMQPublishContractPublishNotifier>;
+    factories["pubbranchheader"] = CZMQAbstractNotifier::Create<CZMQPublishBranchHeaderNotifier>;
+    factories["pubbranchreport"] = CZMQAbstractNotifier::Create<CZMQPublishBranchReportNotifier>;
+    factories["pubbranchsettle"] = CZMQAbstractNotifier::Create<CZMQPublishBranchSettleNotifier>;
 
     for (std::map<std::string, CZMQNotifierFactory>::const_iterator i=factories.begin(); i!=factories.end(); ++i)
     {
@@ -172,6 +177,40 @@ void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const MCBlo
         // Do a normal notify for each transaction added in the block
         TransactionAddedToMempool(ptx);
     }
+
+    // Contract publishing and branch chain events are read from the block transactions
+    for (size_t n = 0; n < pblock->vtx.size(); n++) {
+        for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+        {
+            CZMQAbstractNotifier *notifier = *i;
+            if (notifier->NotifyBlockTransaction(*pblock->vtx[n], pindexConnected, n))
+            {
+                i++;
+            }
+            else
+            {
+                notifier->Shutdown();
+                i = notifiers.erase(i);
+            }
+        }
+    }
+}
+
+void CZMQNotificationInterface::ContractDataUpdated(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash)
+{
+    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
+    {
+        CZMQAbstractNotifier *notifier = *i;
+        if (notifier->NotifyContractData(contractId, pindex, txIndex, dataHash))
+        {
+            i++;
+        }
+        else
+        {
+            notifier->Shutdown();
+            i = notifiers.erase(i);
+        }
+    }
 }
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const MCBlock>& pblock)
@@ -30,6 +30,7 @@ protected:
     void BlockConnected(const std::shared_ptr<const MCBlock>& pblock, const MCBlockIndex* pindexConnected, const std::vector<MCTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const std::shared_ptr<const MCBlock>& pblock) override;
     void UpdatedBlockTip(const MCBlockIndex *pindexNew, const MCBlockIndex *pindexFork, bool fInitialDownload) override;
+    void ContractDataUpdated(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash) override;
 
 private:
     CZMQNotificationInterface();
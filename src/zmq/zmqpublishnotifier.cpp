@@ -17,6 +17,11 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_CONTRACTDATA    = "contractdata";
+static const char *MSG_CONTRACTPUBLISH = "contractpublish";
+static const char *MSG_BRANCHHEADER    = "branchheader";
+static const char *MSG_BRANCHREPORT    = "branchreport";
+static const char *MSG_BRANCHSETTLE    = "branchsettle";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -196,3 +201,67 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const MCTransaction &t
     ss << transaction;
     return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
 }
+
+bool CZMQPublishContractDataNotifier::NotifyContractData(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish contractdata %s\n", contractId.GetHex());
+    MCDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << contractId << pindex->GetBlockHash() << txIndex << dataHash;
+    return SendMessage(MSG_CONTRACTDATA, &(*ss.begin()), ss.size());
+}
+
+bool CZMQPublishContractPublishNotifier::NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex)
+{
+    if (transaction.nVersion != MCTransaction::PUBLISH_CONTRACT_VERSION || !transaction.pContractData)
+        return true;
+
+    const ContractData &contractData = *transaction.pContractData;
+    LogPrint(BCLog::ZMQ, "zmq: Publish contractpublish %s\n", contractData.address.GetHex());
+    MCDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << contractData.address << pindex->GetBlockHash() << txIndex << transaction.GetHash() << contractData.sender;
+    return SendMessage(MSG_CONTRACTPUBLISH, &(*ss.begin()), ss.size());
+}
+
+bool CZMQPublishBranchHeaderNotifier::NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex)
+{
+    if (!transaction.IsSyncBranchInfo() || !transaction.pBranchBlockData)
+        return true;
+
+    const MCBranchBlockInfo &info = *transaction.pBranchBlockData;
+    MCBlockHeader header;
+    info.GetBlockHeader(header);
+    LogPrint(BCLog::ZMQ, "zmq: Publish branchheader %s\n", header.GetHash().GetHex());
+    MCDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << info.branchID << header.GetHash() << info.blockHeight << pindex->GetBlockHash() << transaction.GetHash();
+    return SendMessage(MSG_BRANCHHEADER, &(*ss.begin()), ss.size());
+}
+
+bool CZMQPublishBranchReportNotifier::NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex)
+{
+    MCDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    if (transaction.IsReport() && transaction.pReportData) {
+        const ReportData &report = *transaction.pReportData;
+        ss << (uint8_t)0 << report.reporttype << report.reportedBranchId << report.reportedBlockHash << report.reportedTxHash;
+    }
+    else if (transaction.IsProve() && transaction.pProveData) {
+        const ProveData &prove = *transaction.pProveData;
+        ss << (uint8_t)1 << prove.provetype << prove.branchId << prove.blockHash << prove.txHash;
+    }
+    else
+        return true;
+
+    LogPrint(BCLog::ZMQ, "zmq: Publish branchreport %s\n", transaction.GetHash().GetHex());
+    ss << pindex->GetBlockHash() << transaction.GetHash();
+    return SendMessage(MSG_BRANCHREPORT, &(*ss.begin()), ss.size());
+}
+
+bool CZMQPublishBranchSettleNotifier::NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex)
+{
+    if (!transaction.IsBranchChainTransStep2())
+        return true;
+
+    LogPrint(BCLog::ZMQ, "zmq: Publish branchsettle %s\n", transaction.GetHash().GetHex());
+    MCDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << transaction.fromBranchId << (int64_t)transaction.inAmount << pindex->GetBlockHash() << transaction.GetHash();
+    return SendMessage(MSG_BRANCHSETTLE, &(*ss.begin()), ss.size());
+}
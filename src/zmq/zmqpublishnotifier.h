@@ -53,4 +53,44 @@ public:
     bool NotifyTransaction(const MCTransaction &transaction) override;
 };
 
+/* The contract and branch chain notifiers below publish fixed layouts in
+   network serialization, hashes in internal byte order, so that indexers can
+   follow the chain without RPC. blockhash is the block of this chain that
+   contains the transaction. */
+
+/* contractid(20) | blockhash(32) | txindex(int32) | datahash(32) */
+class CZMQPublishContractDataNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyContractData(const MCContractID &contractId, const MCBlockIndex *pindex, int32_t txIndex, const uint256 &dataHash) override;
+};
+
+/* contractid(20) | blockhash(32) | txindex(int32) | txid(32) | sender pubkey */
+class CZMQPublishContractPublishNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex) override;
+};
+
+/* branchid(32) | branch blockhash(32) | branch height(uint32) | blockhash(32) | txid(32) */
+class CZMQPublishBranchHeaderNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex) override;
+};
+
+/* kind(uint8, 0 report 1 prove) | type(int32) | branchid(32) | reported blockhash(32) | reported txid(32) | blockhash(32) | txid(32) */
+class CZMQPublishBranchReportNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex) override;
+};
+
+/* from branchid(string) | amount(int64) | blockhash(32) | txid(32) */
+class CZMQPublishBranchSettleNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTransaction(const MCTransaction &transaction, const MCBlockIndex *pindex, int32_t txIndex) override;
+};
+
 #endif // MAGNACHAIN_ZMQ_ZMQPUBLISHNOTIFIER_H